@@ -1,6 +1,16 @@
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/epoll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+
+#include <algorithm>
 #include <chrono>
+#include <cstdlib>
+#include <cstring>
 #include <thread>
 
+#include "fbraw.h"
 #include "logger.h"
 #include "print.h"
 
@@ -11,8 +21,10 @@ Logger gLogger; // global logger instance
 // The Application
 Application::Application( Config cfg )
     : config(cfg),
-        sdl(config.screen_width, config.screen_height),
-        redis(config.RedisHostIP, config.RedisPort)
+        sdl(config.screen_width, config.screen_height, (size_t)std::max(0, config.ImageCacheMB) << 20),
+        redis(config.RedisHostIP, config.RedisPort),
+        redisAsync(config.RedisHostIP, config.RedisPort),
+        commandQueue(config.RedisHostIP, config.RedisPort, config.CommandQueueKey, config.CommandBatch)
 {
 }
 
@@ -24,7 +36,12 @@ int Application::parse_argv(int argc, char *argv[])
         std::string arg = argv[i];
         if ((arg == "--loglevel" || arg == "-l") && i + 1 < argc)
         {
-            logLevel = static_cast<LogLevel>(std::stoi(argv[++i]));
+            LogLevel level;
+            if (Logger::ParseLevel(argv[++i], level)) {
+                Logger::SetLevel(level);
+            } else {
+                println("Unknown log level ", argv[i], ", want error|warn|info|debug or 0..3");
+            }
         }
         else if ((arg == "--config" || arg == "-c") && i + 1 < argc)
         {
@@ -38,13 +55,25 @@ int Application::parse_argv(int argc, char *argv[])
 
 bool Application::Initialise( bool continueOnFail )
 {
+    // Ctrl-C / kill end the loop through the reactor - set up before any thread inherits the mask
+    reactor.WatchSignals({SIGINT, SIGTERM}, [this](int) { quit = true; });
+
     bool loggerOpened = gLogger.Open( config.LogFile );
     if (!loggerOpened) {
         println("Failed to open log file: ", config.LogFile);
     }
-    gLogger.log("Log level set to: ", (int)logLevel);
+    gLogger.log("Log level set to: ", Logger::LevelName(Logger::Level()));
 
     //1 SDL
+    sdl.SetPrefetchThreads(config.PrefetchThreads);
+    sdl.SetFbDevice(config.FbDevice);
+    sdl.SetDrmDevice(config.DrmDevice);
+    sdl.SetScaling(config.ScaleMode, config.ScaleFilter);
+    sdl.SetRenderThreads(config.RenderThreads);
+    sdl.SetDirtyTiles(config.DirtyTiles != 0);
+    sdl.SetDirectDecode(config.DirectDecode != 0);
+    sdl.SetProgressive(config.ProgressiveDisplay != 0);
+    sdl.SetTransition(config.Transition, config.TransitionMs, config.TransitionFps);
     if (!sdl.Initialise(config.WindowTitle, config.DrawMode, config.RGBOrder, config.SDLAutoInit))
     {
         gLogger.log("Failed to initialize SDL!");
@@ -56,6 +85,7 @@ bool Application::Initialise( bool continueOnFail )
     gLogger.log("Initialized SDL ", sdl.isInitialized() ? "OK" : "ERROR");
 
     //2 DB / NET
+    redisAsync.Start(); // non-blocking client for everything on the render loop
     bool redisConn = redis.Connect();
     if ( ! redisConn )
     {
@@ -65,6 +95,17 @@ bool Application::Initialise( bool continueOnFail )
         gLogger.log("Connected to Redis server OK");
     }
 
+    instanceName = config.InstanceName;
+    if (instanceName.empty())
+    {
+        char host[256] = {};
+        gethostname(host, sizeof(host) - 1);
+        instanceName = host;
+    }
+
+    startSubscription(); // keeps retrying in the background, polling covers the gaps
+    startCommandQueue();
+
     gLogger.log("Application initialization DONE.");
 
     return true; // NOTE: continue even if SDL or Redis failed
@@ -74,16 +115,201 @@ void Application::Run()
 {
     SDL_Event e;
 
+    startTimers();
+    watchInput();
+
     while (!quit)
     {
         handleEvents(e);
+        runPosted(); // replies from the async redis thread
         updateFromRedis();
-        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+        if (!quit) {
+            reactor.RunOnce(); // sleep until input, a timer, a redis push or a signal
+        }
     }
 }
 
+void Application::wake()
+{
+    reactor.Wake();
+}
+
+void Application::startTimers()
+{
+    reactor.AddTimer(std::chrono::seconds(5), [this] { heartbeatDue = true; });
+    pollTimer = reactor.AddTimer(std::chrono::milliseconds(0), [this] { pollDue = true; }); // armed in updateFromRedis
+}
+
+void Application::watchInput()
+{
+    std::string driver = sdl.VideoDriver();
+    if (driver == "x11" || driver == "wayland")
+    {
+        // window events come over the display server socket, which SDL keeps to itself
+        reactor.AddTimer(std::chrono::milliseconds(std::max(1, config.EventPumpMs)), [] {});
+        gLogger.log("Reactor: pumping SDL events every ", config.EventPumpMs, " ms (", driver, ")");
+        return;
+    }
+
+    // console drivers read evdev themselves; our own fds only say "input pending" and get drained
+    for (int i = 0; i < 32; ++i) {
+        watchInputDevice("/dev/input/event" + std::to_string(i));
+    }
+
+    // devices plugged in later: udev creates the node, then fixes its permissions (IN_ATTRIB)
+    inputWatchFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (inputWatchFd >= 0 && inotify_add_watch(inputWatchFd, "/dev/input", IN_CREATE | IN_ATTRIB) >= 0)
+    {
+        reactor.Add(inputWatchFd, EPOLLIN, [this](uint32_t)
+        {
+            alignas(inotify_event) char buf[4096];
+            ssize_t n;
+            while ((n = read(inputWatchFd, buf, sizeof buf)) > 0)
+            {
+                for (char* p = buf; p < buf + n; p += sizeof(inotify_event) + ((inotify_event*)p)->len)
+                {
+                    auto* ev = (inotify_event*)p;
+                    if (ev->len > 0 && strncmp(ev->name, "event", 5) == 0) {
+                        watchInputDevice(std::string("/dev/input/") + ev->name);
+                    }
+                }
+            }
+        });
+    }
+    else
+    {
+        gLogger.log("Reactor: no inotify on /dev/input, devices plugged in later do not wake the loop");
+        if (inputWatchFd >= 0) {
+            close(inputWatchFd);
+            inputWatchFd = -1;
+        }
+    }
+
+    gLogger.log("Reactor: waking on ", inputDevices.size(), " input device(s)");
+}
+
+void Application::watchInputDevice(const std::string& dev)
+{
+    for (const auto& [fd, name] : inputDevices) {
+        if (name == dev) return; // IN_ATTRIB fires again for devices already open
+    }
+
+    int fd = open(dev.c_str(), O_RDONLY | O_NONBLOCK | O_CLOEXEC);
+    if (fd < 0) {
+        return;
+    }
+
+    reactor.Add(fd, EPOLLIN, [this, fd](uint32_t events)
+    {
+        char buf[1024];
+        while (read(fd, buf, sizeof buf) > 0) {}
+
+        if (events & (EPOLLERR | EPOLLHUP)) // unplugged
+        {
+            reactor.Remove(fd);
+            close(fd);
+            inputDevices.erase(fd);
+        }
+    });
+    inputDevices[fd] = dev;
+}
+
+void Application::startSubscription()
+{
+    if (config.SubscribeMode == "keyspace")
+    {
+        // a subscription that never fires would switch polling off for good
+        if (!redis.EnableKeyspaceEvents(config.KeyspaceConfigSet != 0) && redis.isConnected()) {
+            return;
+        }
+
+        // any write to KEY fires an event; the value itself is read with GET
+        std::vector<std::string> patterns{"__keyspace@*__:" + config.KEY};
+        if (config.ImageSource == "redis") {
+            patterns.push_back("__keyspace@*__:" + config.ImageBlobKeyPrefix + "*"); // blob writes: cache is stale
+        }
+
+        redis.Subscribe(patterns, true,
+            [this](const std::string& channel, const std::string& event) 
+            {
+                if (channel.compare(channel.find(':') + 1, std::string::npos, config.KEY) != 0) {
+                    blobVersion++;
+                }
+                else if (event == "set" || event == "del" || event == "expired") {
+                    noteKeyChanged();
+                    wake();
+                }
+            },
+            [this](bool subscribed) 
+            {
+                if (subscribed) {
+                    imageKeyChanged = true; // catch up on anything missed
+                    blobVersion++;          // including blob writes
+                }
+                wake(); // and switch polling off / on
+            });
+    }
+    else if (config.SubscribeMode == "channel")
+    {
+        // publisher sends the new id as the payload - no GET needed
+        redis.Subscribe({config.SubscribeChannel}, false,
+            [this](const std::string&, const std::string& id) 
+            {
+                {
+                    std::lock_guard<std::mutex> lock(pushedMtx);
+                    pushedId = id;
+                }
+                noteKeyChanged();
+                wake();
+            },
+            [this](bool subscribed) 
+            {
+                if (subscribed) imageKeyChanged = true;
+                wake();
+            });
+    }
+}
+
+void Application::startCommandQueue()
+{
+    // claimed on the queue thread, executed here on the main thread, answered back in one ack
+    commandQueue.SetConsumer(instanceName); // own processing list per viewer
+    commandQueue.Start([this](const std::vector<RedisCommandQueue::Command>& batch, RedisCommandQueue::Done done)
+    {
+        post([this, batch, done]
+        {
+            // some answers come later (redis blobs are fetched async) - done() once all are in
+            auto responses = std::make_shared<std::vector<std::string>>(batch.size());
+            auto left = std::make_shared<size_t>(batch.size());
+            for (size_t i = 0; i < batch.size(); ++i)
+            {
+                runRemoteCommand(batch[i], [responses, left, done, i](std::string answer)
+                {
+                    (*responses)[i] = std::move(answer);
+                    if (--*left == 0) {
+                        done(std::move(*responses));
+                    }
+                });
+            }
+        });
+    });
+}
+
 void Application::Shutdown()
 {
+    commandQueue.Stop(); // unanswered commands stay queued for the next start
+    for (const auto& [fd, name] : inputDevices) {
+        reactor.Remove(fd);
+        close(fd);
+    }
+    inputDevices.clear();
+    if (inputWatchFd >= 0) {
+        reactor.Remove(inputWatchFd);
+        close(inputWatchFd);
+        inputWatchFd = -1;
+    }
+    redisAsync.Stop();
     redis.Disconnect();
     sdl.Shutdown();
 }
@@ -100,6 +326,11 @@ void Application::handleEvents(SDL_Event& e)
         {
             quit = true;
         }
+        else if (e.type == SDL_DISPLAYEVENT || 
+                 (e.type == SDL_WINDOWEVENT && e.window.event == SDL_WINDOWEVENT_SIZE_CHANGED))
+        {
+            sdl.RefreshFramebuffer(); // mode may have changed under the mapping
+        }
     }
 }
 
@@ -110,36 +341,265 @@ std::string Application::formImagePath( std::string id )
 
 void Application::updateFromRedis()
 {
-    static auto last_check = std::chrono::steady_clock::now();
-    static auto last_heartbeat = std::chrono::steady_clock::now();
-    auto now = std::chrono::steady_clock::now();
-
-    // Send heartbeat every 5 seconds
-    if (std::chrono::duration_cast<std::chrono::seconds>(now - last_heartbeat).count() >= 5)
+    // Send heartbeat every 5 seconds (reactor timer)
+    if (heartbeatDue)
     {
+        heartbeatDue = false;
         sendHeartbeat();
-        last_heartbeat = now;
     }
 
-    // Check for remote commands
-    handleRemoteCommands();
+    // pushed change: act now; otherwise poll, but only while no subscription is live
+    bool wantPoll = !redis.isSubscribed();
+    if (wantPoll != pollArmed)
+    {
+        // RefreshTimeGET_sec 0 = every kMinPollPeriod, not "off"
+        auto period = std::max<std::chrono::milliseconds>(
+            std::chrono::seconds(std::max(0, config.RefreshTimeGET_sec)), kMinPollPeriod);
+        reactor.SetTimer(pollTimer, wantPoll ? period : std::chrono::milliseconds(0));
+        pollArmed = wantPoll;
+    }
+    if (!wantPoll) {
+        pollDue = false;
+    }
 
-    if (std::chrono::duration_cast<std::chrono::seconds>(now - last_check).count() >= config.RefreshTimeGET_sec)
+    if (imageGetInFlight) {
+        return; // answer still on its way - keep the flags for the next round
+    }
+
+    bool pushed = imageKeyChanged.exchange(false);
+    if (!pushed && !pollDue) {
+        return;
+    }
+    pollDue = false;
+    uint64_t observedNs = keyChangedNs.exchange(0); // 0 (poll) = now
+
+    std::string id;
     {
-        auto id = redis.GetString(std::string(config.KEY));
+        std::lock_guard<std::mutex> lock(pushedMtx);
+        id.swap(pushedId);
+    }
+    if (!id.empty()) {
+        showImage(id, pushed ? "Pushed" : "Polled", false, observedNs);
+        return;
+    }
 
-        if (!id.empty() && id != crntImgName)
+    // GET on the I/O thread, display back here on the main thread
+    if (observedNs == 0) {
+        observedNs = StageClock::NowNs();
+    }
+    imageGetInFlight = true;
+    redisAsync.Command({"GET", config.KEY}, [this, pushed, observedNs](const RedisAsync::Reply& reply)
+    {
+        post([this, pushed, observedNs, reply]
         {
-            bool ok = sdl.DisplayImage(formImagePath(id));
-            if (ok)
-            {
-                crntImgName = id;
+            imageGetInFlight = false;
+            if (reply.type == REDIS_REPLY_STRING) {
+                showImage(reply.str, pushed ? "Pushed" : "Polled", false, observedNs);
             }
+        });
+    });
+}
+
+void Application::noteKeyChanged()
+{
+    uint64_t none = 0;
+    keyChangedNs.compare_exchange_strong(none, StageClock::NowNs()); // keep the earliest
+    imageKeyChanged = true;
+}
+
+void Application::showImage(const std::string& id, const char* how, bool force, uint64_t observedNs, Shown shown)
+{
+    if (id.empty() || (id == crntImgName && !force))
+    {
+        if (shown) shown(!id.empty());
+        return;
+    }
+
+    sdl.Stages().Begin(observedNs);
+    sdl.Stages().Mark(PipelineStage::Started);
+
+    if (config.ImageSource == "redis") {
+        showBlob(id, how, force, std::move(shown));
+        return;
+    }
+
+    bool ok = sdl.DisplayImage(formImagePath(id));
+    if (ok)
+    {
+        crntImgName = id;
+        displayed(id);
+        schedulePrefetch(id);
+        PRINTI("OK (display) ", how, " image: img", id, ".png");
+    }
+    else
+    {
+        PRINTW("ERR (display) ", how, " image: img", id, ".png");
+    }
+    if (shown) shown(ok);
+}
+
+// Every successful switch: latency histograms, then one stream entry for load generators
+// (mono_ns is CLOCK_MONOTONIC - only comparable on the same host; real_ms is wall time)
+void Application::displayed(const std::string& id)
+{
+    const StageClock& clock = sdl.Stages();
+    metrics.Record(clock);
+
+    if (config.AckStream.empty()) {
+        return;
+    }
+    uint64_t observed = clock.At(PipelineStage::Observed);
+    uint64_t presented = clock.At(PipelineStage::Presented);
+    uint64_t now = StageClock::NowNs();
+    int64_t realMs = std::chrono::duration_cast<std::chrono::milliseconds>(
+                         std::chrono::system_clock::now().time_since_epoch()).count();
+
+    redisAsync.Command({"XADD", config.AckStream, "MAXLEN", "~", std::to_string(std::max(1, config.AckStreamMaxLen)), "*",
+                        "id", id,
+                        "instance", instanceName,
+                        "mono_ns", std::to_string(presented ? presented : now),
+                        "real_ms", std::to_string(realMs),
+                        "latency_us", std::to_string(observed && presented > observed ? (presented - observed) / 1000 : 0)},
+                       nullptr);
+}
 
-            println(ok? "OK":"ERR", " (display) Polled image: img",  id, ".png");
+// Encoded image straight from redis: decoded from memory, cached under its key
+void Application::showBlob(const std::string& id, const char* how, bool force, Shown shown)
+{
+    std::string key = config.ImageBlobKeyPrefix + id;
+    blobWanted = id;
+
+    // a cached blob is only as good as the keyspace events that would have invalidated it
+    int64_t version = blobVersion;
+    bool cacheTrusted = config.SubscribeMode == "keyspace" && redis.isSubscribed();
+
+    if (force) {
+        sdl.InvalidateImage(key);
+    }
+    else if (cacheTrusted && sdl.DisplayCachedImage(key, version))
+    {
+        crntImgName = id;
+        displayed(id);
+        PRINTI("OK (display) ", how, " image: ", key, " (cached)");
+        if (shown) shown(true);
+        return;
+    }
+
+    redisAsync.GetBinary(key, (size_t)std::max(4096, config.BlobChunkBytes),
+        [this, id, key, how, version, shown](bool ok, std::string data)
+        {
+            auto bytes = std::make_shared<std::string>(std::move(data)); // no copy through post()
+            post([this, id, key, how, version, shown, ok, bytes]
+            {
+                if (id != blobWanted) // a newer id was requested meanwhile
+                {
+                    if (shown) shown(false);
+                    return;
+                }
+
+                sdl.Stages().Mark(PipelineStage::Opened);
+                bool onScreen = ok && sdl.DisplayImageData(key, bytes->data(), bytes->size(), version);
+                if (onScreen) {
+                    crntImgName = id;
+                    displayed(id);
+                    PRINTI("OK (display) ", how, " image: ", key, " (", bytes->size(), " bytes)");
+                } else {
+                    PRINTW("ERR (display) ", how, " image: ", key, " (", bytes->size(), " bytes)");
+                }
+                if (shown) shown(onScreen);
+            });
+        });
+}
+
+void Application::post(std::function<void()> task)
+{
+    {
+        std::lock_guard<std::mutex> lock(tasksMtx);
+        tasks.push_back(std::move(task));
+    }
+    wake();
+}
+
+void Application::runPosted()
+{
+    std::vector<std::function<void()>> ready;
+    {
+        std::lock_guard<std::mutex> lock(tasksMtx);
+        ready.swap(tasks);
+    }
+    for (auto& task : ready) {
+        task();
+    }
+}
+
+// Guess the next images and let the background workers decode them
+void Application::schedulePrefetch(const std::string& id)
+{
+    if (config.PrefetchThreads <= 0 || config.PrefetchAhead <= 0 || config.ImageSource != "file") {
+        return; // workers decode files only
+    }
+
+    if (!config.PrefetchListKey.empty())
+    {
+        // playlist published by the backend: the ids after this one, in order
+        // (LPOS needs redis >= 6.0.6; not in the list / older server = from the head)
+        redisAsync.Command({"LPOS", config.PrefetchListKey, id}, [this, id](const RedisAsync::Reply& pos)
+        {
+            long long first = pos.type == REDIS_REPLY_INTEGER ? pos.integer + 1 : 0;
+            long long last = first + config.PrefetchAhead - 1;
+            redisAsync.Command({"LRANGE", config.PrefetchListKey, std::to_string(first), std::to_string(last)},
+                [this, id](const RedisAsync::Reply& list)
+                {
+                    post([this, id, list]
+                    {
+                        if (id == crntImgName) { // not switched away meanwhile
+                            prefetchIds(id, list.elements);
+                        }
+                    });
+                });
+        });
+        return;
+    }
+
+    // numeric neighbours: id+1, id-1, id+2, id-2, ...
+    char* end = nullptr;
+    long n = std::strtol(id.c_str(), &end, 10);
+    if (end == id.c_str() || *end != '\0') {
+        return; // not a number - nothing to guess
+    }
+
+    std::vector<std::string> ids;
+    for (long d = 1; (int)ids.size() < config.PrefetchAhead; ++d)
+    {
+        ids.push_back(std::to_string(n + d));
+        if ((int)ids.size() < config.PrefetchAhead && n - d >= 0) {
+            ids.push_back(std::to_string(n - d));
         }
-        last_check = now;
     }
+
+    prefetchIds(id, ids);
+}
+
+void Application::prefetchIds(const std::string& id, const std::vector<std::string>& ids)
+{
+    std::vector<std::string> paths;
+    for (const auto& next : ids)
+    {
+        if (next != id) {
+            paths.push_back(formImagePath(next));
+        }
+    }
+
+    if (config.ImageExtension == ".fbraw")
+    {
+        // nothing to decode - just have the pages in memory before they are mapped
+        for (const auto& path : paths) {
+            FbRawImage::Readahead(path);
+        }
+        return;
+    }
+
+    sdl.Prefetch(paths);
 }
 
 void Application::sendHeartbeat()
@@ -151,46 +611,133 @@ void Application::sendHeartbeat()
     char timestamp[64];
     std::strftime(timestamp, sizeof(timestamp), "%Y-%m-%d %H:%M:%S", &tm);
     
-    redis.SetString("App:Heartbeat", std::string(timestamp));
+    // one write for the whole heartbeat, on the async client - a stalled link never holds up the display
+    RedisBatch batch;
+    batch.Set("App:Heartbeat", std::string(timestamp));
     
     // Also set configuration values for remote console
-    redis.SetString("Config:RedisHost", config.RedisHostIP);
-    redis.SetString("Config:RedisPort", std::to_string(config.RedisPort));
-    redis.SetString("Config:ImageFolder", config.ImageFolder);
-    redis.SetString("Config:RefreshInterval", std::to_string(config.RefreshTimeGET_sec));
-    redis.SetString("Config:ScreenWidth", std::to_string(config.screen_width));
-    redis.SetString("Config:ScreenHeight", std::to_string(config.screen_height));
+    batch.Set("Config:RedisHost", config.RedisHostIP)
+         .Set("Config:RedisPort", std::to_string(config.RedisPort))
+         .Set("Config:ImageFolder", config.ImageFolder)
+         .Set("Config:RefreshInterval", std::to_string(config.RefreshTimeGET_sec))
+         .Set("Config:ScreenWidth", std::to_string(config.screen_width))
+         .Set("Config:ScreenHeight", std::to_string(config.screen_height));
+
+    // Decoded image cache effectiveness
+    auto cs = sdl.GetCacheStats();
+    batch.Set("App:CacheStats", "hits=" + std::to_string(cs.hits) +
+                                " misses=" + std::to_string(cs.misses) +
+                                " evictions=" + std::to_string(cs.evictions) +
+                                " entries=" + std::to_string(cs.entries) +
+                                " warmed=" + std::to_string(cs.warmed) +
+                                " bytes=" + std::to_string(cs.bytes));
+
+    // DrawMode 2/3 page flip latency (vsync wait + pan / atomic commit -> flip event)
+    auto fs = sdl.GetFlipStats();
+    if (fs.flips > 0)
+    {
+        batch.Set("App:FlipStats", "flips=" + std::to_string(fs.flips) +
+                                   " last_us=" + std::to_string(fs.lastUs) +
+                                   " avg_us=" + std::to_string(fs.totalUs / fs.flips) +
+                                   " max_us=" + std::to_string(fs.maxUs));
+    }
+
+    // DrawMode 2 dirty tiles: how much of each frame actually went to the fb
+    auto ds = sdl.GetDirtyStats();
+    if (ds.frames > 0)
+    {
+        uint64_t total = ds.bytesWritten + ds.bytesSkipped;
+        batch.Set("App:DirtyStats", "frames=" + std::to_string(ds.frames) +
+                                    " tiles_written=" + std::to_string(ds.tilesWritten) +
+                                    " tiles_skipped=" + std::to_string(ds.tilesSkipped) +
+                                    " bytes_written=" + std::to_string(ds.bytesWritten) +
+                                    " bytes_skipped=" + std::to_string(ds.bytesSkipped) +
+                                    " written_pct=" + std::to_string(total ? ds.bytesWritten * 100 / total : 0));
+    }
+
+    // png/jpeg decoded straight into the fb format vs handed to SDL_image (scaled, interlaced...)
+    auto dd = sdl.GetDecodeStats();
+    if (dd.decoded + dd.unsupported + dd.failed > 0)
+    {
+        batch.Set("App:DecodeStats", "direct=" + std::to_string(dd.decoded) +
+                                     " surface=" + std::to_string(dd.unsupported) +
+                                     " failed=" + std::to_string(dd.failed));
+    }
+
+    // progressive display: time to the first decoded row on screen vs the whole frame
+    auto ps = sdl.GetProgressiveStats();
+    if (ps.images > 0)
+    {
+        batch.Set("App:ProgressiveStats", "images=" + std::to_string(ps.images) +
+                                          " first_row_us=" + std::to_string(ps.lastFirstRowUs) +
+                                          " full_us=" + std::to_string(ps.lastFullUs) +
+                                          " avg_first_row_us=" + std::to_string(ps.totalFirstRowUs / ps.images) +
+                                          " avg_full_us=" + std::to_string(ps.totalFullUs / ps.images));
+    }
+
+    // per-stage switch latency histograms: key change -> started -> ... -> presented, and total
+    if (metrics.Switches() > 0)
+    {
+        std::vector<std::string> hset = {"HSET", "App:Metrics"};
+        std::vector<std::string> fields = metrics.HashFields();
+        hset.insert(hset.end(), fields.begin(), fields.end());
+        batch.Command(std::move(hset));
+    }
+
+    // crossfade/slide pacing: steps shown vs refresh periods missed
+    auto ts = sdl.GetTransitionStats();
+    if (ts.transitions > 0)
+    {
+        batch.Set("App:TransitionStats", "transitions=" + std::to_string(ts.transitions) +
+                                         " frames=" + std::to_string(ts.frames) +
+                                         " dropped=" + std::to_string(ts.dropped) +
+                                         " last_ms=" + std::to_string(ts.lastMs) +
+                                         " max_frame_us=" + std::to_string(ts.maxFrameUs));
+    }
+
+    // async logger: lines lost to a full queue
+    if (gLogger.Dropped() > 0)
+    {
+        batch.Set("App:LogStats", "written=" + std::to_string(gLogger.Written()) +
+                                  " dropped=" + std::to_string(gLogger.Dropped()));
+    }
+
+    redisAsync.Pipeline(batch.Commands());
 }
 
-void Application::handleRemoteCommands()
+void Application::runRemoteCommand(const RedisCommandQueue::Command& command, std::function<void(std::string)> answer)
 {
-    auto command = redis.GetString("App:Command");
-    
-    if (!command.empty())
+    PRINTI("Received remote command: ", command.cmd, command.id.empty() ? "" : " (id " + command.id + ")");
+
+    if (command.cmd == "refresh") // Force refresh of current image
     {
-        println("Received remote command: ", command);
-        
-        if (command == "refresh") // Force refresh of current image
+        sdl.RefreshFramebuffer();
+        redisAsync.Command({"GET", config.KEY}, [this](const RedisAsync::Reply& reply)
         {
-            auto id = redis.GetString(std::string(config.KEY));
-            if (!id.empty())
+            post([this, reply]
             {
-                bool ok = sdl.DisplayImage(formImagePath(id));
-                if ( ok )
-                {
-                    crntImgName = id;
+                if (reply.type == REDIS_REPLY_STRING) {
+                    showImage(reply.str, "Refreshed", true);
                 }
-
-                println(ok? "OK" : "ERR", " (display) Refreshed image: img",  id, ".png");
-            }
-        }
-        else if (command == "status") // Send status response
+            });
+        });
+        answer("OK");
+    }
+    else if (command.cmd == "show" && !command.args.empty()) // Display an image id right away
+    {
+        // answered once it is on screen - later for ImageSource redis
+        std::string id = command.args[0];
+        showImage(id, "Commanded", false, 0, [id, answer](bool shown)
         {
-            std::string status = "Running - Current Image: " + crntImgName;
-            redis.SetString("App:Response", status);
-        }
-        
-        // Clear the command after processing
-        redis.Delete("App:Command");
+            answer(shown ? "OK" : "ERR cannot display " + id);
+        });
+    }
+    else if (command.cmd == "status") // Send status response
+    {
+        answer("Running - Current Image: " + crntImgName);
     }
-}
\ No newline at end of file
+    else
+    {
+        answer("ERR unknown command: " + command.cmd);
+    }
+}
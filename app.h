@@ -1,7 +1,19 @@
 
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
 #include "logger.h"
+#include "reactor.h"
+#include "redis_async.h"
+#include "redis_cmdqueue.h"
 #include "redis_conn.h"
 #include "sdl_ctx.h"
+#include "stage_metrics.h"
 
 
 //-------------------------------------------------------------------
@@ -16,17 +28,44 @@ public:
         int RedisPort = 6379;
 
         std::string KEY = "ImageId"; // redis key to monitor
-        int RefreshTimeGET_sec = 2;
+        int RefreshTimeGET_sec = 2; // GET poll while no subscription is live, 0 = as often as allowed (100 ms)
         std::string ImageFolder = "/var/lib/redis-image-viewer/images/";
         std::string ImageExtension = ".png";
         std::string ImagePrefix = "img";
+        std::string ImageSource = "file"; // file=ImageFolder, redis=encoded bytes in ImageBlobKeyPrefix<id>
+        std::string ImageBlobKeyPrefix = "Image:Blob:";
+        int BlobChunkBytes = 262144; // GETRANGE size per round trip
 
         int screen_width = 800;
         int screen_height = 600;
         std::string WindowTitle = "Redis Image Viewer";
-        int DrawMode = 2; // 0=DRM, 1=Blit, 2=Direct memwrite
+        int DrawMode = 2; // 0=DRM, 1=Blit, 2=Direct memwrite, 3=KMS atomic (libdrm)
+        std::string FbDevice = "/dev/fb0"; // DrawMode 2, "virtual:WxHxBPP[,...]" = RAM fake (fb_device.h)
+        std::string DrmDevice = "/dev/dri/card0"; // DrawMode 3
         int RGBOrder = 0; // 0=RGB, 1=BGR
+        std::string ScaleMode = "fit"; // fit|fill|stretch|center|none - into screen_width x screen_height
+        std::string ScaleFilter = "bilinear"; // bilinear|nearest
+        int RenderThreads = 0; // pixel workers for scale/convert/copy, 0 = one per core (max 4)
+        int DirectDecode = 0; // DrawMode 2/3: 1:1 png/jpeg decoded straight into the fb format (libpng/libjpeg builds), bypasses ImageCache
+        int ProgressiveDisplay = 0; // DrawMode 2/3 + DirectDecode, no transition: rows shown as they decode
+        int DirtyTiles = 0; // DrawMode 2: diff against the last frame, write only changed 64x16 tiles (slow scanout memory)
+        std::string Transition = "cut"; // cut|crossfade|slide between images
+        int TransitionMs = 500;
+        int TransitionFps = 60; // display refresh: drop detection, pacing when there is no vsync
         int SDLAutoInit = 0; // 0=off, 1=on
+        int ImageCacheMB = 64; // decoded image cache budget, 0=off
+        int PrefetchThreads = 1; // background decode workers, 0=off
+        int PrefetchAhead = 2; // how many predicted ids to decode ahead
+        std::string PrefetchListKey = ""; // redis playlist: the ids after the current one are prefetched, empty = numeric neighbours
+        std::string SubscribeMode = "keyspace"; // keyspace=__keyspace@*__:KEY, channel=SubscribeChannel, off=poll only
+        std::string SubscribeChannel = "App:ImageChanged"; // pub/sub channel, payload = new image id
+        int KeyspaceConfigSet = 0; // keyspace: 1 = CONFIG SET notify-keyspace-events if the server lacks K$
+        std::string CommandQueueKey = "App:Commands"; // remote command list (LPUSH), answers in KEY:response:<id>
+        int CommandBatch = 32; // max commands claimed and answered per round
+        std::string AckStream = "App:Displayed"; // XADD id + timestamps after each present, "" = off
+        int AckStreamMaxLen = 10000; // approximate trim
+        std::string InstanceName = ""; // ack "instance" field and command queue consumer, "" = hostname
+        int EventPumpMs = 10; // SDL event polling on x11/wayland only; console drivers wake on /dev/input
 
         std::string LogFile = ""; // to console
 
@@ -34,8 +73,6 @@ public:
         
         bool loadFromFile(const std::string &filename);
     };
-    enum class LogLevel { Info,  Warn ,  Debug};
-
     // API
     Application( Config cfg);    
     bool Initialise(bool continueOnFail );
@@ -48,16 +85,57 @@ private:
     void handleEvents(SDL_Event& e);
     void updateFromRedis();
     void sendHeartbeat();
-    void handleRemoteCommands();
+    void startCommandQueue();
     std::string formImagePath(std::string id);
+    void schedulePrefetch(const std::string& id); // predicted next ids, playlist fetched async
+    void prefetchIds(const std::string& id, const std::vector<std::string>& ids); // decode / readahead
+    void startSubscription();
+    void noteKeyChanged(); // from the subscriber thread: stamp + flag
+    void wake(); // cut the reactor wait short (from the subscriber / redis I/O threads)
+    void post(std::function<void()> task); // run on the main thread (from redis I/O callbacks)
+    void runPosted();
+    using Shown = std::function<void(bool shown)>; // on screen or not, once the (async) display finished
+    void showImage(const std::string& id, const char* how, bool force = false, uint64_t observedNs = 0, // 0 = now
+                   Shown shown = nullptr);
+    void showBlob(const std::string& id, const char* how, bool force, Shown shown);
+    void displayed(const std::string& id); // on screen: metrics + ack stream entry
+    void runRemoteCommand(const RedisCommandQueue::Command& command, std::function<void(std::string)> answer);
+    void startTimers();
+    void watchInput();
+    void watchInputDevice(const std::string& dev); // open + add to the reactor, once per node
 private:
     Config config;
+
+    // pushed by the subscriber thread, consumed by updateFromRedis
+    // (declared before redis so they - and the reactor - outlive its subscriber thread)
+    std::atomic<bool> imageKeyChanged{false};
+    std::atomic<uint64_t> keyChangedNs{0}; // first push since the last switch (StageClock::NowNs)
+    std::mutex pushedMtx;
+    std::string pushedId; // channel mode carries the id itself
+    std::atomic<int64_t> blobVersion{0}; // cached blobs are decoded under it; bumped on blob writes and resubscribe
+    std::mutex tasksMtx;
+    std::vector<std::function<void()>> tasks;
+
+    Reactor reactor; // main thread sleeps here; wake() is its eventfd
+    int pollTimer = -1; // armed only while no subscription is live
+    bool pollArmed = false;
+    bool heartbeatDue = true;
+    bool pollDue = true;
+    std::unordered_map<int, std::string> inputDevices; // fd -> /dev/input/eventN, readable = SDL has input to pump
+    int inputWatchFd = -1; // inotify on /dev/input for hot-plugged devices
+
     SDLContext sdl;
     RedisConnect redis;
+    RedisAsync redisAsync; // render-loop reads/writes, never blocks
+    RedisCommandQueue commandQueue; // own connection + thread, commands run on the main thread
+    bool imageGetInFlight = false;
+    std::string blobWanted; // latest requested blob id - older fetches finishing late are dropped
+    static constexpr std::chrono::milliseconds kMinPollPeriod{100}; // image GET poll
     bool quit = false;
     std::string crntImgName = "";
+    PipelineMetrics metrics; // per-stage switch latency, published as App:Metrics
+    std::string instanceName; // AckStream "instance" field
 public:
-    static inline LogLevel logLevel = LogLevel::Info; // Default log level
     // Default to system-installed config; can be overridden via --config
     static inline std::string CfgFile = "/etc/redis-image-viewer/config.json";
 };
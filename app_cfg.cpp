@@ -49,6 +49,12 @@ bool Application::Config::loadFromFile(const std::string &filename)
       ImageExtension = j["ImageExtension"].string_value();
     if (j["ImagePrefix"].is_string())
       ImagePrefix = j["ImagePrefix"].string_value();
+    if (j["ImageSource"].is_string())
+      ImageSource = j["ImageSource"].string_value();
+    if (j["ImageBlobKeyPrefix"].is_string())
+      ImageBlobKeyPrefix = j["ImageBlobKeyPrefix"].string_value();
+    if (j["BlobChunkBytes"].is_number())
+      BlobChunkBytes = j["BlobChunkBytes"].int_value();
 
     // Screen configuration
     if (j["screen_width"].is_number())
@@ -60,10 +66,58 @@ bool Application::Config::loadFromFile(const std::string &filename)
 
     if (j["DrawMode"].is_number())
       DrawMode = j["DrawMode"].int_value();
+    if (j["FbDevice"].is_string())
+      FbDevice = j["FbDevice"].string_value();
+    if (j["DrmDevice"].is_string())
+      DrmDevice = j["DrmDevice"].string_value();
     if (j["RGBOrder"].is_number())
       RGBOrder = j["RGBOrder"].int_value();
+    if (j["ScaleMode"].is_string())
+      ScaleMode = j["ScaleMode"].string_value();
+    if (j["ScaleFilter"].is_string())
+      ScaleFilter = j["ScaleFilter"].string_value();
+    if (j["RenderThreads"].is_number())
+      RenderThreads = j["RenderThreads"].int_value();
+    if (j["DirectDecode"].is_number())
+      DirectDecode = j["DirectDecode"].int_value();
+    if (j["ProgressiveDisplay"].is_number())
+      ProgressiveDisplay = j["ProgressiveDisplay"].int_value();
+    if (j["DirtyTiles"].is_number())
+      DirtyTiles = j["DirtyTiles"].int_value();
+    if (j["Transition"].is_string())
+      Transition = j["Transition"].string_value();
+    if (j["TransitionMs"].is_number())
+      TransitionMs = j["TransitionMs"].int_value();
+    if (j["TransitionFps"].is_number())
+      TransitionFps = j["TransitionFps"].int_value();
     if (j["SDLAutoInit"].is_number())
       SDLAutoInit = j["SDLAutoInit"].int_value();
+    if (j["ImageCacheMB"].is_number())
+      ImageCacheMB = j["ImageCacheMB"].int_value();
+    if (j["PrefetchThreads"].is_number())
+      PrefetchThreads = j["PrefetchThreads"].int_value();
+    if (j["PrefetchAhead"].is_number())
+      PrefetchAhead = j["PrefetchAhead"].int_value();
+    if (j["PrefetchListKey"].is_string())
+      PrefetchListKey = j["PrefetchListKey"].string_value();
+    if (j["SubscribeMode"].is_string())
+      SubscribeMode = j["SubscribeMode"].string_value();
+    if (j["SubscribeChannel"].is_string())
+      SubscribeChannel = j["SubscribeChannel"].string_value();
+    if (j["KeyspaceConfigSet"].is_number())
+      KeyspaceConfigSet = j["KeyspaceConfigSet"].int_value();
+    if (j["CommandQueueKey"].is_string())
+      CommandQueueKey = j["CommandQueueKey"].string_value();
+    if (j["CommandBatch"].is_number())
+      CommandBatch = j["CommandBatch"].int_value();
+    if (j["AckStream"].is_string())
+      AckStream = j["AckStream"].string_value();
+    if (j["AckStreamMaxLen"].is_number())
+      AckStreamMaxLen = j["AckStreamMaxLen"].int_value();
+    if (j["InstanceName"].is_string())
+      InstanceName = j["InstanceName"].string_value();
+    if (j["EventPumpMs"].is_number())
+      EventPumpMs = j["EventPumpMs"].int_value();
 
     if (j["LogFile"].is_string())
       LogFile = j["LogFile"].string_value();
@@ -0,0 +1,146 @@
+// Pixel conversion benchmark: SDL_ConvertSurfaceFormat + memcpy vs. the pixel_convert kernels,
+// then the render path (scale/convert, dirty tile diff) on a 4K panel for 1..N threads
+//   make bench_convert && ./bench_convert [image.png] [iterations] [max threads]
+
+#include <SDL2/SDL.h>
+#include <SDL2/SDL_image.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "dirty_tiles.h"
+#include "image_scale.h"
+#include "pixel_convert.h"
+#include "print.h"
+
+static Uint32 toSDL(DstPixelFormat f)
+{
+    switch (f) {
+        case DstPixelFormat::RGB565:   return SDL_PIXELFORMAT_RGB565;
+        case DstPixelFormat::BGR565:   return SDL_PIXELFORMAT_BGR565;
+        case DstPixelFormat::XRGB8888: return SDL_PIXELFORMAT_XRGB8888;
+        default:                       return SDL_PIXELFORMAT_XBGR8888;
+    }
+}
+
+template <typename F>
+static double msPerFrame(int iterations, F&& frame)
+{
+    frame(); // warm up caches and page in the destination
+    auto t0 = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; ++i) {
+        frame();
+    }
+    auto t1 = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::milli>(t1 - t0).count() / iterations;
+}
+
+// Same work as DrawMode 2 on a 3840x2160 XRGB8888 panel, thread count swept
+static void threadSweep(SDL_Surface* image, int iterations, int maxThreads)
+{
+    const int panelW = 3840, panelH = 2160;
+    const DstPixelFormat dst = DstPixelFormat::XRGB8888;
+    int pitch = panelW * DstBytesPerPixel(dst);
+    std::vector<uint8_t> fb((size_t)pitch * panelH);
+
+    SDL_Surface* src = SDL_ConvertSurfaceFormat(image, SDL_PIXELFORMAT_RGBA32, 0);
+    SDL_LockSurface(src);
+
+    println("render path, ", panelW, "x", panelH, " ", PixelFormatName(dst), ", 1..", maxThreads, " threads");
+
+    double base[3] = {0, 0, 0};
+    for (int threads = 1; threads <= maxThreads; ++threads)
+    {
+        ImageScaler scaler(threads);
+        ScaleRect box{0, 0, panelW, panelH};
+        ScaleRect srcRect, dstRect;
+        ComputePlacement(src->w, src->h, box, ScaleMode::Fit, srcRect, dstRect);
+
+        double scaleMs = msPerFrame(iterations, [&] {
+            scaler.ScaleInto((const uint8_t*)src->pixels, src->pitch, SrcPixelFormat::RGBA8888, srcRect,
+                             fb.data(), pitch, dst, dstRect, false);
+        });
+
+        ComputePlacement(src->w, src->h, box, ScaleMode::None, srcRect, dstRect);
+        double convertMs = msPerFrame(iterations, [&] {
+            scaler.ScaleInto((const uint8_t*)src->pixels, src->pitch, SrcPixelFormat::RGBA8888, srcRect,
+                             fb.data(), pitch, dst, dstRect, false);
+        });
+
+        // worst case for the diff: every tile compared and written
+        DirtyTiles tiles;
+        tiles.Reset(panelW, panelH, DstBytesPerPixel(dst));
+        double diffMs = msPerFrame(iterations, [&] {
+            tiles.Invalidate();
+            tiles.Commit(fb.data(), pitch, 1, &scaler.Pool());
+        });
+
+        if (threads == 1) {
+            base[0] = scaleMs;
+            base[1] = convertMs;
+            base[2] = diffMs;
+        }
+        println("  ", threads, " threads: scale ", scaleMs, " ms (x", base[0] / scaleMs,
+                "), convert 1:1 ", convertMs, " ms (x", base[1] / convertMs,
+                "), diff+copy ", diffMs, " ms (x", base[2] / diffMs, ")");
+    }
+
+    SDL_UnlockSurface(src);
+    SDL_FreeSurface(src);
+}
+
+int main(int argc, char* argv[])
+{
+    std::string path = argc > 1 ? argv[1] : "images/img0.png";
+    int iterations = argc > 2 ? std::stoi(argv[2]) : 50;
+    int maxThreads = argc > 3 ? std::stoi(argv[3]) : std::max(1, (int)std::thread::hardware_concurrency());
+
+    SDL_Surface* image = IMG_Load(path.c_str());
+    if (image == nullptr) {
+        println("cannot load ", path, ": ", IMG_GetError());
+        return 1;
+    }
+
+    println("image ", path, " ", image->w, "x", image->h, " kernels: ", PixelKernelIsa());
+
+    for (auto srcSdl : {SDL_PIXELFORMAT_RGBA32, SDL_PIXELFORMAT_RGB24})
+    {
+        SDL_Surface* src = SDL_ConvertSurfaceFormat(image, srcSdl, 0);
+        SrcPixelFormat srcFormat = srcSdl == SDL_PIXELFORMAT_RGBA32 ? SrcPixelFormat::RGBA8888
+                                                                    : SrcPixelFormat::RGB888;
+
+        for (auto dst : {DstPixelFormat::RGB565, DstPixelFormat::BGR565,
+                         DstPixelFormat::XRGB8888, DstPixelFormat::XBGR8888})
+        {
+            int pitch = src->w * DstBytesPerPixel(dst);
+            std::vector<uint8_t> fb((size_t)pitch * src->h);
+
+            double sdlMs = msPerFrame(iterations, [&] {
+                SDL_Surface* conv = SDL_ConvertSurfaceFormat(src, toSDL(dst), 0);
+                for (int y = 0; y < conv->h; ++y) {
+                    memcpy(fb.data() + (size_t)y * pitch, (uint8_t*)conv->pixels + (size_t)y * conv->pitch, pitch);
+                }
+                SDL_FreeSurface(conv);
+            });
+
+            ConvertRowFn convert = GetRowConverter(srcFormat, dst, false);
+            double kernelMs = msPerFrame(iterations, [&] {
+                ConvertRows(convert, (const uint8_t*)src->pixels, src->pitch, fb.data(), pitch, src->w, src->h);
+            });
+
+            println(PixelFormatName(srcFormat), " -> ", PixelFormatName(dst),
+                    ": sdl ", sdlMs, " ms, kernel ", kernelMs, " ms, speedup x", sdlMs / kernelMs);
+        }
+
+        SDL_FreeSurface(src);
+    }
+
+    threadSweep(image, iterations, maxThreads);
+
+    SDL_FreeSurface(image);
+    return 0;
+}
@@ -0,0 +1,223 @@
+// Display pipeline benchmark: SDLContext::DisplayImage in every DrawMode on the SDL dummy driver,
+// DrawMode 2 into a virtual (memfd) framebuffer or a given fbdev. Per-stage and end-to-end timings,
+// images/s and allocations per frame as one JSON document on stdout (logs go to bench_display.log).
+//   make bench_display && ./bench_display [image folder] [rounds] [WxH] [fb device] > bench.json
+
+#include <dirent.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include "json11.hpp"
+#include "logger.h"
+#include "print.h"
+#include "sdl_ctx.h"
+#include "stage_metrics.h"
+
+Logger gLogger; // SDLContext logs through it
+
+//-------------------------------------------------------------------
+//* Allocation counting: every malloc/calloc/realloc in the process (operator new included),
+// SDL and the decoders too. glibc only - elsewhere the counts stay 0.
+static std::atomic<uint64_t> gAllocs{0};
+static std::atomic<uint64_t> gAllocBytes{0};
+
+#if defined(__GLIBC__)
+extern "C" {
+void* __libc_malloc(size_t size);
+void* __libc_calloc(size_t count, size_t size);
+void* __libc_realloc(void* p, size_t size);
+
+void* malloc(size_t size) noexcept
+{
+    gAllocs.fetch_add(1, std::memory_order_relaxed);
+    gAllocBytes.fetch_add(size, std::memory_order_relaxed);
+    return __libc_malloc(size);
+}
+
+void* calloc(size_t count, size_t size) noexcept
+{
+    gAllocs.fetch_add(1, std::memory_order_relaxed);
+    gAllocBytes.fetch_add(count * size, std::memory_order_relaxed);
+    return __libc_calloc(count, size);
+}
+
+void* realloc(void* p, size_t size) noexcept
+{
+    gAllocs.fetch_add(1, std::memory_order_relaxed);
+    gAllocBytes.fetch_add(size, std::memory_order_relaxed);
+    return __libc_realloc(p, size);
+}
+}
+#endif
+
+static json11::Json histogramJson(const LatencyHistogram& h)
+{
+    return json11::Json::object{
+        {"count", (double)h.Count()},
+        {"mean", (double)h.Mean()},
+        {"p50", (double)h.Percentile(50)},
+        {"p95", (double)h.Percentile(95)},
+        {"p99", (double)h.Percentile(99)},
+        {"max", (double)h.Max()},
+    };
+}
+
+static std::vector<std::string> listImages(const std::string& folder)
+{
+    std::vector<std::string> paths;
+    std::string dir = folder.empty() || folder.back() == '/' ? folder : folder + "/";
+    DIR* d = opendir(dir.c_str());
+    while (dirent* e = d ? readdir(d) : nullptr)
+    {
+        std::string name = e->d_name;
+        if (name.compare(0, 3, "img") == 0 && name.size() > 4 && name.compare(name.size() - 4, 4, ".png") == 0) {
+            paths.push_back(dir + name);
+        }
+    }
+    if (d) {
+        closedir(d);
+    }
+    std::sort(paths.begin(), paths.end());
+    return paths;
+}
+
+// Every image shown once to warm up, then rounds x images measured
+static json11::Json runMode(int drawMode, const std::vector<std::string>& images, int rounds,
+                            int width, int height, const std::string& fbDevice)
+{
+    json11::Json::object result{{"draw_mode", drawMode}};
+    if (drawMode == 2) {
+        result["fb"] = fbDevice;
+    }
+
+    SDLContext sdl(width, height, 0); // no cache: every frame decodes
+    sdl.SetScaling("fit", "bilinear");
+    sdl.SetRenderThreads(0);
+    sdl.SetDirtyTiles(true);
+    sdl.SetDirectDecode(true);
+    sdl.SetFbDevice(fbDevice);
+
+    bool up = sdl.Initialise("bench_display", drawMode, 0, 0);
+    result["driver"] = sdl.VideoDriver();
+
+    size_t warm = 0;
+    for (const auto& path : images) {
+        warm += up && sdl.DisplayImage(path) ? 1 : 0;
+    }
+    if (warm == 0)
+    {
+        result["skipped"] = drawMode == 3 ? "no KMS device" : "nothing displayed, see bench_display.log";
+        sdl.Shutdown();
+        return result;
+    }
+
+    PipelineMetrics metrics;
+    LatencyHistogram endToEnd;
+    uint64_t failed = 0;
+    uint64_t allocs0 = gAllocs.load(), bytes0 = gAllocBytes.load();
+    auto t0 = std::chrono::steady_clock::now();
+
+    for (int round = 0; round < rounds; ++round)
+    {
+        for (const auto& path : images)
+        {
+            sdl.Stages().Begin(0); // observed = now: no redis in the loop
+            sdl.Stages().Mark(PipelineStage::Started);
+            auto start = std::chrono::steady_clock::now();
+            bool ok = sdl.DisplayImage(path);
+            auto us = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+            if (!ok) {
+                failed++;
+                continue;
+            }
+            endToEnd.Record((uint64_t)us);
+            metrics.Record(sdl.Stages());
+        }
+    }
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+    uint64_t frames = (uint64_t)rounds * images.size();
+    uint64_t allocs = gAllocs.load() - allocs0, bytes = gAllocBytes.load() - bytes0;
+
+    json11::Json::object stages;
+    for (int s = (int)PipelineStage::Started + 1; s < (int)PipelineStage::Count; ++s)
+    {
+        const LatencyHistogram& h = metrics.Stage((PipelineStage)s);
+        if (h.Count() > 0) {
+            stages[PipelineStageName((PipelineStage)s)] = histogramJson(h);
+        }
+    }
+
+    result["frames"] = (double)frames;
+    result["failed"] = (double)failed;
+    result["seconds"] = seconds;
+    result["images_per_s"] = seconds > 0 ? (double)(frames - failed) / seconds : 0.0;
+    result["end_to_end_us"] = histogramJson(endToEnd);
+    result["stages_us"] = stages;
+    result["allocs_per_frame"] = frames ? (double)allocs / frames : 0.0;
+    result["alloc_bytes_per_frame"] = frames ? (double)bytes / frames : 0.0;
+
+    auto decode = sdl.GetDecodeStats();
+    result["direct_decoded"] = (double)decode.decoded;
+    if (drawMode == 2)
+    {
+        auto dirty = sdl.GetDirtyStats();
+        uint64_t total = dirty.bytesWritten + dirty.bytesSkipped;
+        result["fb_written_pct"] = total ? (double)dirty.bytesWritten * 100 / total : 0.0;
+    }
+
+    sdl.Shutdown();
+    return result;
+}
+
+int main(int argc, char* argv[])
+{
+    std::string folder = argc > 1 ? argv[1] : "images/";
+    int rounds = argc > 2 ? std::max(1, std::atoi(argv[2])) : 10;
+    int width = 1920, height = 1080;
+    if (argc > 3 && sscanf(argv[3], "%dx%d", &width, &height) != 2) {
+        println("bad size ", argv[3], ", want WxH");
+        return 1;
+    }
+    std::string virtualFb = "virtual:" + std::to_string(width) + "x" + std::to_string(height);
+    std::string fbDevice = argc > 4 ? argv[4] : virtualFb + "x32";
+
+    std::vector<std::string> images = listImages(folder);
+    if (images.empty()) {
+        println("no img*.png in ", folder);
+        return 1;
+    }
+
+    gLogger.Open("bench_display.log");
+    setenv("SDL_VIDEODRIVER", "dummy", 1); // DrawMode 0/1 without a display
+
+    json11::Json::array modes;
+    for (int drawMode : {0, 1, 2, 3}) {
+        modes.push_back(runMode(drawMode, images, rounds, width, height, fbDevice));
+    }
+    // virtual fb: the other layouts too - RGB565, XBGR8888, and 24 bpp (no kernel - SDL converts)
+    if (argc <= 4)
+    {
+        for (const char* format : {"x16", "x32,rgb=0/8/16", "x24"}) {
+            modes.push_back(runMode(2, images, rounds, width, height, virtualFb + format));
+        }
+    }
+
+    json11::Json report = json11::Json::object{
+        {"width", width},
+        {"height", height},
+        {"images", (int)images.size()},
+        {"rounds", rounds},
+        {"kernels", PixelKernelIsa()},
+        {"render_threads", WorkerPool::DefaultThreads()},
+        {"modes", modes},
+    };
+    println(report.dump());
+    return 0;
+}
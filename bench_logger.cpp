@@ -0,0 +1,149 @@
+// Logger throughput: the async ring logger vs. the previous synchronous one (mutex, localtime,
+// ostringstream, flush and syslog per line), 1/2/4 threads logging display-path lines as fast
+// as they can. Per-call latency on the logging thread, lines/s and what the ring dropped:
+// "async" is log() (waits while the ring is full), "drop" is logOrDrop() (LOGI/LOGD).
+//   make bench_logger && ./bench_logger [lines per thread] [log dir] [--syslog]
+
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "logger.h"
+#include "print.h"
+#include "stage_metrics.h"
+
+//-------------------------------------------------------------------
+//* The Logger before the ring, as it was (syslog made optional for the benchmark)
+class SyncLogger {
+private:
+    std::ofstream logFile;
+    std::mutex logMutex;
+public:
+    bool toSyslog = false;
+
+    bool Open(const std::string& filename)
+    {
+        logFile.open(filename, std::ios::app | std::ios::out);
+        return logFile.is_open();
+    }
+
+    template<typename... Args>
+    void log(Args&&... args)
+    {
+        std::lock_guard<std::mutex> lock(logMutex);
+
+        auto now = std::chrono::system_clock::now();
+        auto time_t = std::chrono::system_clock::to_time_t(now);
+        auto tm = *std::localtime(&time_t);
+
+        char timestamp[64];
+        std::strftime(timestamp, sizeof(timestamp), "%Y-%m-%d %H:%M:%S", &tm);
+
+        std::ostringstream oss;
+        oss << "[" << timestamp << "] ";
+        (oss << ... << args);
+        oss << std::endl;
+
+        auto& out = logFile.is_open() ? logFile : std::cout;
+        out << oss.str();
+        out.flush();
+
+        if (toSyslog) {
+            syslog(LOG_INFO, "%s", oss.str().c_str());
+        }
+    }
+};
+
+// Per-call time in ns (LatencyHistogram buckets are unit-agnostic)
+template <typename L>
+static void run(const char* name, L& logger, int threads, int lines, bool orDrop = false)
+{
+    std::vector<LatencyHistogram> calls(threads);
+    auto emit = [&](auto&&... args)
+    {
+        if constexpr (std::is_same_v<L, Logger>) {
+            if (orDrop) {
+                logger.logOrDrop(args...);
+                return;
+            }
+        }
+        logger.log(args...);
+    };
+    auto t0 = std::chrono::steady_clock::now();
+
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; ++t)
+    {
+        workers.emplace_back([&, t] {
+            for (int i = 0; i < lines; ++i)
+            {
+                uint64_t start = StageClock::NowNs();
+                emit("OK (display) keyspace image: img", i % 6, ".png on thread ", t, ", ", 3.5 * i, " ms");
+                calls[t].Record(StageClock::NowNs() - start);
+            }
+        });
+    }
+    for (auto& w : workers) {
+        w.join();
+    }
+    double callSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+
+    // the slowest thread's per-call percentiles
+    const LatencyHistogram* worst = &calls[0];
+    for (const auto& h : calls) {
+        if (h.Percentile(99) > worst->Percentile(99)) worst = &h;
+    }
+
+    uint64_t total = (uint64_t)threads * lines;
+    uint64_t dropped = 0;
+    if constexpr (std::is_same_v<L, Logger>) {
+        logger.Flush();
+        dropped = logger.Dropped();
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+
+    println(name, " x", threads, ": ", (uint64_t)(total / callSeconds), " calls/s, ",
+            (uint64_t)((total - dropped) / seconds), " lines/s written, dropped ", dropped,
+            ", call p50 ", worst->Percentile(50), " ns, p99 ", worst->Percentile(99), " ns, max ", worst->Max(), " ns");
+}
+
+int main(int argc, char* argv[])
+{
+    int lines = argc > 1 ? std::max(1, std::atoi(argv[1])) : 100000;
+    std::string dir = argc > 2 ? argv[2] : "/tmp";
+    bool withSyslog = argc > 3 && strcmp(argv[3], "--syslog") == 0;
+
+    for (int threads : {1, 2, 4})
+    {
+        std::string file = dir + "/bench_logger_sync.log";
+        remove(file.c_str());
+        SyncLogger sync;
+        sync.toSyslog = withSyslog;
+        sync.Open(file);
+        run("sync ", sync, threads, lines);
+    }
+
+    for (int threads : {1, 2, 4})
+    {
+        std::string file = dir + "/bench_logger_async.log";
+        remove(file.c_str());
+        Logger async;
+        async.SetSyslog(withSyslog);
+        async.Open(file);
+        run("async", async, threads, lines);
+    }
+
+    for (int threads : {1, 2, 4})
+    {
+        std::string file = dir + "/bench_logger_async.log";
+        remove(file.c_str());
+        Logger async;
+        async.SetSyslog(withSyslog);
+        async.Open(file);
+        run("drop ", async, threads, lines, true);
+    }
+    return 0;
+}
@@ -0,0 +1,63 @@
+// Round-trip benchmark: the heartbeat as separate blocking SETs vs. one pipelined RedisBatch
+//   make bench_redis && ./bench_redis [host] [port] [iterations]
+
+#include <chrono>
+#include <string>
+
+#include "logger.h"
+#include "print.h"
+#include "redis_conn.h"
+
+Logger gLogger; // redis_conn.cpp logs through it
+
+static const int kKeys = 9; // heartbeat + 6 Config:* + CacheStats + FlipStats
+
+template <typename F>
+static void run(const char* name, RedisConnect& redis, int iterations, F&& heartbeat)
+{
+    uint64_t rt0 = redis.RoundTrips();
+    auto t0 = std::chrono::steady_clock::now();
+
+    for (int i = 0; i < iterations; ++i) {
+        heartbeat(i);
+    }
+
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+    println(name, ": ", (double)(redis.RoundTrips() - rt0) / iterations, " round trips/heartbeat, ",
+            ms / iterations, " ms/heartbeat");
+}
+
+int main(int argc, char* argv[])
+{
+    std::string host = argc > 1 ? argv[1] : "127.0.0.1";
+    int port = argc > 2 ? std::stoi(argv[2]) : 6379;
+    int iterations = argc > 3 ? std::stoi(argv[3]) : 1000;
+
+    RedisConnect redis(host, port);
+    redis.Connect();
+    if (!redis.isConnected()) {
+        println("cannot connect to ", host, ":", port);
+        return 1;
+    }
+
+    run("separate SETs", redis, iterations, [&](int i) {
+        for (int k = 0; k < kKeys; ++k) {
+            redis.SetString("Bench:Key" + std::to_string(k), std::to_string(i));
+        }
+    });
+
+    run("RedisBatch   ", redis, iterations, [&](int i) {
+        RedisBatch batch;
+        for (int k = 0; k < kKeys; ++k) {
+            batch.Set("Bench:Key" + std::to_string(k), std::to_string(i));
+        }
+        redis.Exec(batch);
+    });
+
+    RedisBatch cleanup;
+    for (int k = 0; k < kKeys; ++k) {
+        cleanup.Delete("Bench:Key" + std::to_string(k));
+    }
+    redis.Exec(cleanup);
+    return 0;
+}
@@ -9,6 +9,19 @@ REDIS_IMAGE_VIEWER_LICENSE = unknown
 REDIS_IMAGE_VIEWER_DEPENDENCIES = sdl2 sdl2_image hiredis
 REDIS_IMAGE_VIEWER_SUPPORTS_IN_SOURCE_BUILD = NO
 
+# KMS atomic backend (DrawMode 3) when libdrm is in the image
+ifeq ($(BR2_PACKAGE_LIBDRM),y)
+REDIS_IMAGE_VIEWER_DEPENDENCIES += libdrm
+endif
+
+# Direct png/jpeg decode into the fb format (DirectDecode) when the libraries are in the image
+ifeq ($(BR2_PACKAGE_LIBPNG),y)
+REDIS_IMAGE_VIEWER_DEPENDENCIES += libpng
+endif
+ifeq ($(BR2_PACKAGE_JPEG),y)
+REDIS_IMAGE_VIEWER_DEPENDENCIES += jpeg
+endif
+
 # Keep the default CMAKE_INSTALL_PREFIX (/usr) set by Buildroot.
 REDIS_IMAGE_VIEWER_CONF_OPTS += -DCMAKE_BUILD_TYPE=Release
 
@@ -0,0 +1,177 @@
+#include <algorithm>
+#include <cstring>
+
+#if defined(__ARM_NEON)
+#include <arm_neon.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#include "dirty_tiles.h"
+
+namespace {
+
+// OR of the XORs over the span, one test at the end - tiles are short, early exit is per row
+bool sameBytes(const uint8_t* a, const uint8_t* b, int bytes)
+{
+    int i = 0;
+#if defined(__ARM_NEON)
+    uint8x16_t diff = vdupq_n_u8(0);
+    for (; i + 16 <= bytes; i += 16) {
+        diff = vorrq_u8(diff, veorq_u8(vld1q_u8(a + i), vld1q_u8(b + i)));
+    }
+    uint8x8_t folded = vorr_u8(vget_low_u8(diff), vget_high_u8(diff));
+    if (vget_lane_u64(vreinterpret_u64_u8(folded), 0) != 0) {
+        return false;
+    }
+#elif defined(__SSE2__)
+    __m128i diff = _mm_setzero_si128();
+    for (; i + 16 <= bytes; i += 16) {
+        diff = _mm_or_si128(diff, _mm_xor_si128(_mm_loadu_si128((const __m128i*)(a + i)),
+                                                _mm_loadu_si128((const __m128i*)(b + i))));
+    }
+    if (_mm_movemask_epi8(_mm_cmpeq_epi8(diff, _mm_setzero_si128())) != 0xFFFF) {
+        return false;
+    }
+#endif
+    return i == bytes || memcmp(a + i, b + i, bytes - i) == 0;
+}
+
+} // namespace
+
+void DirtyTiles::Reset(int width, int height, int bytesPerPixel)
+{
+    if (width <= 0 || height <= 0 || bytesPerPixel <= 0) {
+        width = height = bytesPerPixel = 0;
+    }
+
+    this->width = width;
+    this->height = height;
+    bpp = bytesPerPixel;
+    pitch = width * bpp;
+    tilesX = (width + kTileW - 1) / kTileW;
+    tilesY = (height + kTileH - 1) / kTileH;
+
+    size_t frameBytes = (size_t)pitch * height;
+    next.assign(frameBytes, 0);
+    shadow.assign(frameBytes, 0);
+    changed.assign((size_t)tilesX * tilesY, 1);
+    changedBefore.assign((size_t)tilesX * tilesY, 1);
+    rowTiles.assign(tilesY, 0);
+    rowBytes.assign(tilesY, 0);
+    if (frameBytes == 0) {
+        next.shrink_to_fit();
+        shadow.shrink_to_fit();
+    }
+    invalid = true;
+}
+
+bool DirtyTiles::tileChanged(int tx, int ty) const
+{
+    int x0 = tx * kTileW;
+    int y0 = ty * kTileH;
+    int bytes = (std::min(kTileW, width - x0)) * bpp;
+    int rows = std::min(kTileH, height - y0);
+
+    size_t offset = (size_t)y0 * pitch + (size_t)x0 * bpp;
+    const uint8_t* a = next.data() + offset;
+    const uint8_t* b = shadow.data() + offset;
+    for (int y = 0; y < rows; ++y, a += pitch, b += pitch) {
+        if (!sameBytes(a, b, bytes)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void DirtyTiles::commitRow(int ty, uint8_t* dst, int dstPitch, int pages)
+{
+    uint8_t* now = changed.data() + (size_t)ty * tilesX;
+    const uint8_t* before = changedBefore.data() + (size_t)ty * tilesX;
+    for (int tx = 0; tx < tilesX; ++tx) {
+        now[tx] = invalid || tileChanged(tx, ty);
+    }
+    auto dirty = [&](int tx) { return now[tx] || (pages > 1 && before[tx]); };
+
+    int y0 = ty * kTileH;
+    int rows = std::min(kTileH, height - y0);
+    int lineBytes = std::min(pitch, dstPitch);
+    uint32_t written = 0;
+    uint64_t writtenBytes = 0;
+
+    // runs of dirty tiles go out as one span per scanline - longer bursts to the device
+    for (int tx = 0; tx < tilesX; )
+    {
+        if (!dirty(tx)) {
+            ++tx;
+            continue;
+        }
+        int run = tx;
+        while (run < tilesX && dirty(run)) ++run;
+
+        int x0 = tx * kTileW * bpp;
+        int bytes = std::min(run * kTileW * bpp, lineBytes) - x0;
+        if (bytes > 0) {
+            for (int y = y0; y < y0 + rows; ++y) {
+                memcpy(dst + (size_t)y * dstPitch + x0, next.data() + (size_t)y * pitch + x0, bytes);
+            }
+            writtenBytes += (uint64_t)bytes * rows;
+        }
+        written += run - tx;
+        tx = run;
+    }
+
+    // bring the shadow up to date where the frame changed - elsewhere it already matches, and
+    // next keeps this frame, so a renderer that leaves pixels alone leaves them as shown
+    for (int tx = 0; tx < tilesX; )
+    {
+        if (!now[tx]) {
+            ++tx;
+            continue;
+        }
+        int run = tx;
+        while (run < tilesX && now[run]) ++run;
+
+        int x0 = tx * kTileW * bpp;
+        int bytes = std::min(run * kTileW * bpp, pitch) - x0;
+        for (int y = y0; y < y0 + rows; ++y) {
+            size_t offset = (size_t)y * pitch + x0;
+            memcpy(shadow.data() + offset, next.data() + offset, bytes);
+        }
+        tx = run;
+    }
+
+    rowTiles[ty] = written;
+    rowBytes[ty] = writtenBytes;
+}
+
+void DirtyTiles::Commit(uint8_t* dst, int dstPitch, int pages, WorkerPool* pool)
+{
+    if (next.empty() || dst == nullptr) {
+        return;
+    }
+
+    changedBefore.swap(changed);
+
+    // a row of tiles is kTileH scanlines of both frames - small enough to stay in one core's cache
+    auto row = [&](int ty) { commitRow(ty, dst, dstPitch, pages); };
+    if (pool != nullptr) {
+        pool->Run(tilesY, row);
+    } else {
+        for (int ty = 0; ty < tilesY; ++ty) row(ty);
+    }
+    invalid = false;
+
+    uint64_t written = 0;
+    uint64_t writtenBytes = 0;
+    for (int ty = 0; ty < tilesY; ++ty) {
+        written += rowTiles[ty];
+        writtenBytes += rowBytes[ty];
+    }
+
+    stats.frames++;
+    stats.tilesWritten += written;
+    stats.tilesSkipped += (uint64_t)tilesX * tilesY - written;
+    stats.bytesWritten += writtenBytes;
+    stats.bytesSkipped += (uint64_t)std::min(pitch, dstPitch) * height - writtenBytes;
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "worker_pool.h"
+
+//-------------------------------------------------------------------
+//* Frame diffing for slow scanout memory - frames are rendered into RAM, compared with the
+// previous one in 64x16 tiles and only the tiles that changed are written to the device.
+class DirtyTiles {
+public:
+    static constexpr int kTileW = 64;
+    static constexpr int kTileH = 16;
+
+    struct Stats {
+        uint64_t frames = 0;
+        uint64_t tilesWritten = 0;
+        uint64_t tilesSkipped = 0;
+        uint64_t bytesWritten = 0;
+        uint64_t bytesSkipped = 0;
+    };
+
+    void Reset(int width, int height, int bytesPerPixel); // new geometry, 0 = release; next frame written in full
+    void Invalidate() { invalid = true; } // device contents unknown (remap, console, ...)
+
+    uint8_t* Frame() { return next.empty() ? nullptr : next.data(); } // render the next frame here
+    int Pitch() const { return pitch; }
+
+    // Write the tiles of Frame() that differ from the last frame into dst.
+    // pages = buffers the display cycles through: with 2, dst still holds the frame before last,
+    // so last frame's changes are written again as well. Tile rows are split over pool.
+    void Commit(uint8_t* dst, int dstPitch, int pages, WorkerPool* pool = nullptr);
+
+    Stats GetStats() const { return stats; }
+
+private:
+    bool tileChanged(int tx, int ty) const;
+    void commitRow(int ty, uint8_t* dst, int dstPitch, int pages); // one row of tiles, own counters
+
+    int width{0}, height{0}, bpp{0}, pitch{0};
+    int tilesX{0}, tilesY{0};
+    std::vector<uint8_t> next;   // frame being rendered
+    std::vector<uint8_t> shadow; // last committed frame
+    std::vector<uint8_t> changed;       // per tile, last commit
+    std::vector<uint8_t> changedBefore; // per tile, the commit before
+    std::vector<uint32_t> rowTiles;     // per tile row, written by the last commit
+    std::vector<uint64_t> rowBytes;
+    bool invalid{true};
+    Stats stats;
+};
@@ -0,0 +1,243 @@
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include "logger.h"
+extern Logger gLogger; // declare external logger instance
+
+#include "fb_device.h"
+
+
+FbDevice::~FbDevice()
+{
+    Close();
+}
+
+//static
+std::unique_ptr<FbDevice> FbDevice::Create(const std::string& device)
+{
+    if (device.compare(0, 8, "virtual:") == 0)
+    {
+        VirtualFbDevice::Options options;
+        if (!VirtualFbDevice::ParseSpec(device.substr(8), options)) {
+            gLogger.log("Framebuffer: bad virtual spec '", device,
+                        "', want virtual:WxHxBPP[,stride=N][,pages=1|2][,rgb=R/G/B][,hz=N][,dump=DIR][,file=PATH]");
+            return nullptr;
+        }
+        return std::make_unique<VirtualFbDevice>(options);
+    }
+    return std::make_unique<LinuxFbDevice>(device);
+}
+
+void FbDevice::Close()
+{
+    if (fd >= 0) {
+        close(fd);
+        fd = -1;
+    }
+}
+
+uint8_t* FbDevice::Map(size_t length)
+{
+    void* p = mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    return p == MAP_FAILED ? nullptr : (uint8_t*)p;
+}
+
+void FbDevice::Unmap(uint8_t* pixels, size_t length)
+{
+    if (pixels != nullptr) {
+        munmap(pixels, length);
+    }
+}
+
+//-------------------------------------------------------------------
+//* LinuxFbDevice
+
+bool LinuxFbDevice::Open()
+{
+    Close();
+    fd = open(name.c_str(), O_RDWR | O_CLOEXEC);
+    return fd >= 0;
+}
+
+bool LinuxFbDevice::ReadInfo(fb_var_screeninfo& vinfo, fb_fix_screeninfo& finfo)
+{
+    return ioctl(fd, FBIOGET_VSCREENINFO, &vinfo) == 0 && ioctl(fd, FBIOGET_FSCREENINFO, &finfo) == 0;
+}
+
+bool LinuxFbDevice::WaitForVsync()
+{
+    __u32 screen = 0;
+    return ioctl(fd, FBIO_WAITFORVSYNC, &screen) == 0;
+}
+
+bool LinuxFbDevice::Pan(const fb_var_screeninfo& pan)
+{
+    fb_var_screeninfo copy = pan; // the driver may write back
+    return ioctl(fd, FBIOPAN_DISPLAY, &copy) == 0;
+}
+
+//-------------------------------------------------------------------
+//* VirtualFbDevice
+
+//static
+bool VirtualFbDevice::ParseSpec(const std::string& spec, Options& options)
+{
+    int used = 0;
+    if (sscanf(spec.c_str(), "%dx%dx%d%n", &options.width, &options.height, &options.bpp, &used) != 3) {
+        return false;
+    }
+
+    size_t at = (size_t)used;
+    while (at < spec.size())
+    {
+        if (spec[at] != ',') {
+            return false;
+        }
+        size_t end = spec.find(',', at + 1);
+        std::string option = spec.substr(at + 1, end == std::string::npos ? std::string::npos : end - at - 1);
+        at = end == std::string::npos ? spec.size() : end;
+
+        size_t eq = option.find('=');
+        std::string key = option.substr(0, eq);
+        std::string value = eq == std::string::npos ? "" : option.substr(eq + 1);
+
+        if (key == "stride") options.stride = atoi(value.c_str());
+        else if (key == "pages") options.pages = atoi(value.c_str());
+        else if (key == "hz") options.hz = atoi(value.c_str());
+        else if (key == "dump") options.dumpDir = value;
+        else if (key == "file") options.file = value;
+        else if (key == "rgb") {
+            if (sscanf(value.c_str(), "%d/%d/%d", &options.red, &options.green, &options.blue) != 3) return false;
+        }
+        else return false;
+    }
+
+    int lineBytes = options.width * options.bpp / 8;
+    return options.width > 0 && options.height > 0 &&
+           (options.bpp == 16 || options.bpp == 24 || options.bpp == 32) &&
+           (options.stride == 0 || options.stride >= lineBytes) &&
+           (options.pages == 1 || options.pages == 2) && options.hz >= 0;
+}
+
+VirtualFbDevice::VirtualFbDevice(const Options& options) : options(options)
+{
+    name = "virtual:" + std::to_string(options.width) + "x" + std::to_string(options.height) +
+           "x" + std::to_string(options.bpp);
+
+    int length = options.bpp == 16 ? 5 : 8;
+    vinfo.xres = vinfo.xres_virtual = options.width;
+    vinfo.yres = options.height;
+    vinfo.yres_virtual = options.height * options.pages;
+    vinfo.bits_per_pixel = options.bpp;
+    vinfo.red = {(__u32)(options.red >= 0 ? options.red : options.bpp == 16 ? 11 : 16), (__u32)length, 0};
+    vinfo.green = {(__u32)(options.green >= 0 ? options.green : options.bpp == 16 ? 5 : 8),
+                   (__u32)(options.bpp == 16 ? 6 : 8), 0};
+    vinfo.blue = {(__u32)(options.blue >= 0 ? options.blue : 0), (__u32)length, 0};
+
+    strncpy(finfo.id, "virtual", sizeof(finfo.id) - 1);
+    finfo.line_length = options.stride > 0 ? options.stride : options.width * options.bpp / 8;
+    finfo.smem_len = finfo.line_length * vinfo.yres_virtual;
+    finfo.type = FB_TYPE_PACKED_PIXELS;
+    finfo.visual = FB_VISUAL_TRUECOLOR;
+}
+
+bool VirtualFbDevice::Open()
+{
+    Close();
+    fd = options.file.empty() ? memfd_create("virtual-fb", MFD_CLOEXEC)
+                              : open(options.file.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (fd < 0 || ftruncate(fd, finfo.smem_len) != 0) {
+        Close();
+        return false;
+    }
+
+    vinfo.xoffset = vinfo.yoffset = 0;
+    epoch = std::chrono::steady_clock::now();
+    shown = 0;
+    return true;
+}
+
+bool VirtualFbDevice::ReadInfo(fb_var_screeninfo& vinfo, fb_fix_screeninfo& finfo)
+{
+    vinfo = this->vinfo;
+    finfo = this->finfo;
+    return true;
+}
+
+bool VirtualFbDevice::WaitForVsync()
+{
+    if (options.hz <= 0) {
+        return false;
+    }
+
+    // sleep to the next tick of a free-running refresh clock
+    auto period = std::chrono::nanoseconds(1000000000LL / options.hz);
+    auto ticks = (std::chrono::steady_clock::now() - epoch) / period + 1;
+    std::this_thread::sleep_until(epoch + ticks * period);
+    return true;
+}
+
+bool VirtualFbDevice::Pan(const fb_var_screeninfo& pan)
+{
+    if (pan.xoffset != 0 || pan.yoffset + vinfo.yres > vinfo.yres_virtual) {
+        return false;
+    }
+    vinfo.yoffset = pan.yoffset;
+    return true;
+}
+
+void VirtualFbDevice::FrameShown(const uint8_t* pixels, uint32_t yoffset)
+{
+    shown++;
+    if (!options.dumpDir.empty())
+    {
+        char file[32];
+        snprintf(file, sizeof(file), "/frame_%06llu.ppm", (unsigned long long)shown);
+        DumpFrame(pixels, yoffset, options.dumpDir + file);
+    }
+}
+
+bool VirtualFbDevice::DumpFrame(const uint8_t* pixels, uint32_t yoffset, const std::string& path) const
+{
+    FILE* f = fopen(path.c_str(), "wb");
+    if (f == nullptr) {
+        gLogger.log("Framebuffer: cannot write ", path);
+        return false;
+    }
+
+    // any channel layout back to 8-bit R,G,B
+    auto channel = [](uint32_t pixel, const fb_bitfield& field) {
+        uint32_t v = (pixel >> field.offset) & ((1u << field.length) - 1);
+        return (uint8_t)(field.length >= 8 ? v >> (field.length - 8)
+                                           : (v << (8 - field.length)) | (v >> (2 * field.length - 8)));
+    };
+
+    int bytes = vinfo.bits_per_pixel / 8;
+    std::vector<uint8_t> rgb((size_t)vinfo.xres * 3);
+    fprintf(f, "P6\n%u %u\n255\n", vinfo.xres, vinfo.yres);
+    for (uint32_t y = 0; y < vinfo.yres; ++y)
+    {
+        const uint8_t* line = pixels + (size_t)(yoffset + y) * finfo.line_length;
+        for (uint32_t x = 0; x < vinfo.xres; ++x)
+        {
+            uint32_t pixel = 0;
+            for (int b = 0; b < bytes; ++b) {
+                pixel |= (uint32_t)line[x * bytes + b] << (8 * b); // little-endian, as scanned out
+            }
+            rgb[x * 3 + 0] = channel(pixel, vinfo.red);
+            rgb[x * 3 + 1] = channel(pixel, vinfo.green);
+            rgb[x * 3 + 2] = channel(pixel, vinfo.blue);
+        }
+        fwrite(rgb.data(), 1, rgb.size(), f);
+    }
+    fclose(f);
+    return true;
+}
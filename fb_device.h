@@ -0,0 +1,88 @@
+#pragma once
+
+#include <linux/fb.h>
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+//-------------------------------------------------------------------
+//* What Framebuffer needs from an fbdev: mode info, a shared mapping, vsync and pan.
+// Create() picks the backend from the device string:
+//   "/dev/fbN"                   - kernel fbdev, ioctl + mmap
+//   "virtual:WxHxBPP[,opt=val]"  - RAM-backed fake, see VirtualFbDevice::Options
+class FbDevice {
+public:
+    virtual ~FbDevice();
+
+    static std::unique_ptr<FbDevice> Create(const std::string& device); // nullptr (logged) on a bad spec
+
+    virtual bool Open() = 0;
+    void Close();
+    const std::string& Name() const { return name; }
+
+    virtual bool ReadInfo(fb_var_screeninfo& vinfo, fb_fix_screeninfo& finfo) = 0; // current mode
+    uint8_t* Map(size_t length); // MAP_SHARED on the device fd, nullptr on failure
+    void Unmap(uint8_t* pixels, size_t length);
+
+    virtual bool WaitForVsync() = 0; // false = not supported
+    virtual bool Pan(const fb_var_screeninfo& pan) = 0; // xoffset/yoffset of the page to show
+    virtual void FrameShown(const uint8_t* /*pixels*/, uint32_t /*yoffset*/) {} // after every Flip()
+
+protected:
+    std::string name;
+    int fd{-1};
+};
+
+//-------------------------------------------------------------------
+//* /dev/fbN
+class LinuxFbDevice : public FbDevice {
+public:
+    explicit LinuxFbDevice(const std::string& path) { name = path; }
+
+    bool Open() override;
+    bool ReadInfo(fb_var_screeninfo& vinfo, fb_fix_screeninfo& finfo) override;
+    bool WaitForVsync() override;
+    bool Pan(const fb_var_screeninfo& pan) override;
+};
+
+//-------------------------------------------------------------------
+//* Framebuffer in a memfd (or a file) with a made-up mode - runs and profiles the direct-write
+// path, every pixel format and page flipping on any Linux box, and can dump what is shown.
+class VirtualFbDevice : public FbDevice {
+public:
+    struct Options {
+        int width = 0;
+        int height = 0;
+        int bpp = 32;               // 16, 24 or 32
+        int stride = 0;             // line_length in bytes, 0 = width * bpp / 8
+        int pages = 2;              // 2 = yres_virtual is twice yres: page flipping
+        int red = -1, green = -1, blue = -1; // channel offsets, -1 = XRGB8888 / RGB565 layout
+        int hz = 0;                 // simulated vsync, 0 = none (FBIO_WAITFORVSYNC unsupported)
+        std::string dumpDir;        // every shown frame as <dir>/frame_NNNNNN.ppm
+        std::string file;           // back with this file instead of a memfd
+    };
+
+    // "WxHxBPP[,stride=N][,pages=1|2][,rgb=R/G/B][,hz=N][,dump=DIR][,file=PATH]"
+    static bool ParseSpec(const std::string& spec, Options& options);
+
+    explicit VirtualFbDevice(const Options& options);
+
+    bool Open() override;
+    bool ReadInfo(fb_var_screeninfo& vinfo, fb_fix_screeninfo& finfo) override;
+    bool WaitForVsync() override;
+    bool Pan(const fb_var_screeninfo& pan) override;
+    void FrameShown(const uint8_t* pixels, uint32_t yoffset) override;
+
+    bool DumpFrame(const uint8_t* pixels, uint32_t yoffset, const std::string& path) const; // binary PPM
+    uint64_t FramesShown() const { return shown; }
+
+private:
+    Options options;
+    fb_var_screeninfo vinfo{};
+    fb_fix_screeninfo finfo{};
+    std::chrono::steady_clock::time_point epoch; // vsync ticks count from Open()
+    uint64_t shown{0};
+};
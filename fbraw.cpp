@@ -0,0 +1,195 @@
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+#include "fbraw.h"
+#include "print.h"
+
+static const char kMagic[8] = {'F', 'B', 'R', 'A', 'W', '0', '1', '\0'};
+
+static constexpr uint32_t fourcc(char a, char b, char c, char d)
+{
+    return (uint32_t)a | ((uint32_t)b << 8) | ((uint32_t)c << 16) | ((uint32_t)d << 24);
+}
+
+//static
+uint32_t FbRawImage::FourCC(DstPixelFormat format)
+{
+    switch (format) {
+        case DstPixelFormat::RGB565:   return fourcc('R', 'G', '1', '6');
+        case DstPixelFormat::BGR565:   return fourcc('B', 'G', '1', '6');
+        case DstPixelFormat::XRGB8888: return fourcc('X', 'R', '2', '4');
+        case DstPixelFormat::XBGR8888: return fourcc('X', 'B', '2', '4');
+        default:                       return 0;
+    }
+}
+
+//static
+DstPixelFormat FbRawImage::FormatFromFourCC(uint32_t code)
+{
+    for (auto f : {DstPixelFormat::RGB565, DstPixelFormat::BGR565,
+                   DstPixelFormat::XRGB8888, DstPixelFormat::XBGR8888}) {
+        if (FourCC(f) == code) return f;
+    }
+    return DstPixelFormat::Unknown;
+}
+
+//static
+bool FbRawImage::IsFbRawPath(const std::string& path)
+{
+    static const std::string ext = ".fbraw";
+    return path.size() > ext.size() && path.compare(path.size() - ext.size(), ext.size(), ext) == 0;
+}
+
+//static
+void FbRawImage::Readahead(const std::string& path)
+{
+    int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd >= 0) {
+        posix_fadvise(fd, 0, 0, POSIX_FADV_WILLNEED);
+        close(fd);
+    }
+}
+
+FbRawImage::~FbRawImage()
+{
+    Close();
+}
+
+bool FbRawImage::Open(const std::string& path)
+{
+    Close();
+
+    int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        println("fbraw: cannot open ", path);
+        return false;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(FbRawHeader)) {
+        println("fbraw: ", path, " too short");
+        close(fd);
+        return false;
+    }
+
+    void* m = mmap(nullptr, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd); // the mapping keeps the file
+    if (m == MAP_FAILED) {
+        println("fbraw: mmap ", path, " failed: ", strerror(errno));
+        return false;
+    }
+    madvise(m, (size_t)st.st_size, MADV_SEQUENTIAL);
+
+    map = m;
+    mapSize = (size_t)st.st_size;
+
+    const FbRawHeader& h = Header();
+    int bpp = DstBytesPerPixel(Format());
+    bool ok = memcmp(h.magic, kMagic, sizeof kMagic) == 0 &&
+              bpp > 0 && h.stride >= h.width * (uint32_t)bpp &&
+              h.dataOffset >= sizeof(FbRawHeader) &&
+              (uint64_t)h.dataOffset + (uint64_t)h.stride * h.height <= mapSize;
+    if (!ok) {
+        println("fbraw: ", path, " has a bad header");
+        Close();
+        return false;
+    }
+    return true;
+}
+
+void FbRawImage::Close()
+{
+    if (map != nullptr) {
+        munmap(map, mapSize);
+        map = nullptr;
+        mapSize = 0;
+    }
+}
+
+bool FbRawImage::CopyInto(uint8_t* dst, int dstPitch, int dstW, int dstH, DstPixelFormat dstFormat) const
+{
+    if (!isOpen()) {
+        return false;
+    }
+
+    const FbRawHeader& h = Header();
+    DstPixelFormat srcFormat = Format();
+    int bpp = DstBytesPerPixel(dstFormat);
+    int width = std::min((int)h.width, dstW);
+    int rows = std::min((int)h.height, dstH);
+
+    if (srcFormat == dstFormat)
+    {
+        if ((int)h.stride == dstPitch && width == dstW) {
+            memcpy(dst, Pixels(), (size_t)dstPitch * rows); // converted for this panel: one copy
+        } else {
+            for (int y = 0; y < rows; y++) {
+                memcpy(dst + (long)y * dstPitch, Pixels() + (long)y * h.stride, (size_t)width * bpp);
+            }
+        }
+    }
+    else
+    {
+        // 32-bit files are B,G,R,X (XRGB8888) or R,G,B,X (XBGR8888) bytes - valid kernel sources
+        SrcPixelFormat asSrc = srcFormat == DstPixelFormat::XRGB8888 ? SrcPixelFormat::BGRA8888
+                             : srcFormat == DstPixelFormat::XBGR8888 ? SrcPixelFormat::RGBA8888
+                             : SrcPixelFormat::Unknown;
+        ConvertRowFn convert = asSrc == SrcPixelFormat::Unknown ? nullptr : GetRowConverter(asSrc, dstFormat, false);
+        if (convert == nullptr) {
+            println("fbraw: ", PixelFormatName(srcFormat), " file on a ", PixelFormatName(dstFormat), " panel - convert it again");
+            return false;
+        }
+        ConvertRows(convert, Pixels(), h.stride, dst, dstPitch, width, rows);
+    }
+
+    if (width < dstW) {
+        for (int y = 0; y < rows; y++) {
+            memset(dst + (long)y * dstPitch + width * bpp, 0, (size_t)(dstW - width) * bpp);
+        }
+    }
+    for (int y = rows; y < dstH; y++) {
+        memset(dst + (long)y * dstPitch, 0, (size_t)dstW * bpp);
+    }
+    return true;
+}
+
+//static
+bool FbRawImage::Write(const std::string& path, const uint8_t* pixels,
+                       int width, int height, int stride, DstPixelFormat format)
+{
+    FbRawHeader h{};
+    memcpy(h.magic, kMagic, sizeof kMagic);
+    h.width = (uint32_t)width;
+    h.height = (uint32_t)height;
+    h.stride = (uint32_t)stride;
+    h.fourcc = FourCC(format);
+    h.dataOffset = kDataOffset;
+
+    std::string tmp = path + ".tmp"; // readers never map a half-written file
+    int fd = open(tmp.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        println("fbraw: cannot create ", tmp);
+        return false;
+    }
+
+    std::string pad(kDataOffset - sizeof h, '\0');
+    size_t dataBytes = (size_t)stride * height;
+    bool ok = write(fd, &h, sizeof h) == (ssize_t)sizeof h &&
+              write(fd, pad.data(), pad.size()) == (ssize_t)pad.size() &&
+              write(fd, pixels, dataBytes) == (ssize_t)dataBytes;
+    ok = close(fd) == 0 && ok;
+
+    if (!ok || rename(tmp.c_str(), path.c_str()) != 0) {
+        println("fbraw: writing ", path, " failed");
+        unlink(tmp.c_str());
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "pixel_convert.h"
+
+//-------------------------------------------------------------------
+//* .fbraw - image pre-converted to scanout layout, shown with a plain copy (no decode)
+// Little-endian header, pixel rows start at dataOffset (page aligned) so the file maps cleanly.
+struct FbRawHeader {
+    char magic[8];       // "FBRAW01"
+    uint32_t width;
+    uint32_t height;
+    uint32_t stride;     // bytes per row, usually the panel's line_length
+    uint32_t fourcc;     // DRM fourcc of DstPixelFormat (RG16, BG16, XR24, XB24)
+    uint32_t dataOffset;
+    uint32_t reserved;
+};
+static_assert(sizeof(FbRawHeader) == 32, "on-disk layout");
+
+class FbRawImage {
+public:
+    static constexpr uint32_t kDataOffset = 4096;
+
+    FbRawImage() = default;
+    ~FbRawImage();
+
+    FbRawImage(const FbRawImage&) = delete;
+    FbRawImage& operator=(const FbRawImage&) = delete;
+
+    bool Open(const std::string& path); // mmap read-only, validates header and size
+    void Close();
+    bool isOpen() const { return map != nullptr; }
+
+    const FbRawHeader& Header() const { return *(const FbRawHeader*)map; }
+    DstPixelFormat Format() const { return FormatFromFourCC(Header().fourcc); }
+    const uint8_t* Pixels() const { return (const uint8_t*)map + Header().dataOffset; }
+
+    // Rows straight into a scanout buffer; uncovered area cleared. Same format = memcpy,
+    // 32-bit into another format goes through the pixel kernels.
+    bool CopyInto(uint8_t* dst, int dstPitch, int dstW, int dstH, DstPixelFormat dstFormat) const;
+
+    static bool Write(const std::string& path, const uint8_t* pixels,
+                      int width, int height, int stride, DstPixelFormat format);
+    static bool IsFbRawPath(const std::string& path); // by extension
+    static void Readahead(const std::string& path);   // hint the page cache, returns at once
+
+    static uint32_t FourCC(DstPixelFormat format);
+    static DstPixelFormat FormatFromFourCC(uint32_t fourcc);
+
+private:
+    void* map{nullptr};
+    size_t mapSize{0};
+};
@@ -0,0 +1,170 @@
+// Batch convert PNG/JPEG into .fbraw for one panel (DrawMode 2/3 then only copies)
+//   fbraw_convert [--fb /dev/fb0 | --size WxH --format RGB565|BGR565|XRGB8888|XBGR8888] [--bgr] <folder|image>...
+// Writes <name>.fbraw next to each input. Set "ImageExtension": ".fbraw" to use them.
+
+#include <SDL2/SDL.h>
+#include <SDL2/SDL_image.h>
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <linux/fb.h>
+#include <sys/ioctl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "fbraw.h"
+#include "pixel_convert.h"
+#include "print.h"
+
+struct Panel {
+    int width = 0;
+    int height = 0;
+    int stride = 0; // 0 = width * bpp
+    DstPixelFormat format = DstPixelFormat::Unknown;
+};
+
+static bool panelFromFb(const std::string& device, Panel& panel)
+{
+    int fd = open(device.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        println("cannot open ", device);
+        return false;
+    }
+
+    fb_var_screeninfo vinfo;
+    fb_fix_screeninfo finfo;
+    bool ok = ioctl(fd, FBIOGET_VSCREENINFO, &vinfo) == 0 && ioctl(fd, FBIOGET_FSCREENINFO, &finfo) == 0;
+    close(fd);
+    if (!ok) {
+        println("cannot read the mode of ", device);
+        return false;
+    }
+
+    panel.width = vinfo.xres;
+    panel.height = vinfo.yres;
+    panel.stride = finfo.line_length; // same stride as the fb: one memcpy per image
+    panel.format = DstFormatFromVInfo(vinfo);
+    return true;
+}
+
+static DstPixelFormat formatFromName(const std::string& name)
+{
+    for (auto f : {DstPixelFormat::RGB565, DstPixelFormat::BGR565,
+                   DstPixelFormat::XRGB8888, DstPixelFormat::XBGR8888}) {
+        if (name == PixelFormatName(f)) return f;
+    }
+    return DstPixelFormat::Unknown;
+}
+
+static bool isImage(const std::string& name)
+{
+    std::string lower = name;
+    std::transform(lower.begin(), lower.end(), lower.begin(), ::tolower);
+    for (const char* ext : {".png", ".jpg", ".jpeg"}) {
+        size_t n = strlen(ext);
+        if (lower.size() > n && lower.compare(lower.size() - n, n, ext) == 0) return true;
+    }
+    return false;
+}
+
+static bool convertOne(const std::string& path, const Panel& panel, bool bgr)
+{
+    SDL_Surface* loaded = IMG_Load(path.c_str());
+    if (loaded == nullptr) {
+        println("skip ", path, ": ", IMG_GetError());
+        return false;
+    }
+
+    // one known source layout, then the same kernels the viewer uses
+    SDL_Surface* rgba = SDL_ConvertSurfaceFormat(loaded, SDL_PIXELFORMAT_RGBA32, 0);
+    SDL_FreeSurface(loaded);
+    if (rgba == nullptr) {
+        println("skip ", path, ": ", SDL_GetError());
+        return false;
+    }
+
+    int bpp = DstBytesPerPixel(panel.format);
+    int stride = panel.stride > 0 ? panel.stride : panel.width * bpp;
+    std::vector<uint8_t> frame((size_t)stride * panel.height, 0); // uncovered area stays black
+
+    ConvertRowFn convert = GetRowConverter(SrcPixelFormat::RGBA8888, panel.format, bgr);
+    SDL_LockSurface(rgba);
+    ConvertRows(convert, (const uint8_t*)rgba->pixels, rgba->pitch, frame.data(), stride,
+                std::min(rgba->w, panel.width), std::min(rgba->h, panel.height));
+    SDL_UnlockSurface(rgba);
+    SDL_FreeSurface(rgba);
+
+    std::string out = path.substr(0, path.rfind('.')) + ".fbraw";
+    if (!FbRawImage::Write(out, frame.data(), panel.width, panel.height, stride, panel.format)) {
+        return false;
+    }
+    println(path, " -> ", out);
+    return true;
+}
+
+int main(int argc, char* argv[])
+{
+    Panel panel;
+    bool bgr = false;
+    std::vector<std::string> inputs;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        if (arg == "--fb" && i + 1 < argc) {
+            if (!panelFromFb(argv[++i], panel)) return 1;
+        }
+        else if (arg == "--size" && i + 1 < argc) {
+            if (sscanf(argv[++i], "%dx%d", &panel.width, &panel.height) != 2) {
+                println("bad --size, expected WxH");
+                return 1;
+            }
+        }
+        else if (arg == "--format" && i + 1 < argc) {
+            panel.format = formatFromName(argv[++i]);
+        }
+        else if (arg == "--bgr") {
+            bgr = true; // same as "RGBOrder": 1
+        }
+        else {
+            inputs.push_back(arg);
+        }
+    }
+
+    if (panel.width <= 0 || panel.height <= 0 || panel.format == DstPixelFormat::Unknown || inputs.empty()) {
+        println("usage: fbraw_convert [--fb /dev/fb0 | --size WxH --format RGB565|BGR565|XRGB8888|XBGR8888] [--bgr] <folder|image>...");
+        return 1;
+    }
+
+    IMG_Init(IMG_INIT_PNG | IMG_INIT_JPG);
+    println("panel ", panel.width, "x", panel.height, " ", PixelFormatName(panel.format), bgr ? " (bgr)" : "");
+
+    int converted = 0, failed = 0;
+    for (const auto& input : inputs)
+    {
+        struct stat st;
+        if (stat(input.c_str(), &st) == 0 && S_ISDIR(st.st_mode))
+        {
+            DIR* dir = opendir(input.c_str());
+            std::string folder = input.back() == '/' ? input : input + "/";
+            while (dirent* e = dir ? readdir(dir) : nullptr) {
+                if (isImage(e->d_name)) {
+                    (convertOne(folder + e->d_name, panel, bgr) ? converted : failed)++;
+                }
+            }
+            if (dir) closedir(dir);
+        }
+        else {
+            (convertOne(input, panel, bgr) ? converted : failed)++;
+        }
+    }
+
+    IMG_Quit();
+    println(converted, " converted, ", failed, " failed");
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,234 @@
+#include <chrono>
+#include <cstring>
+
+#include "logger.h"
+extern Logger gLogger; // declare external logger instance
+
+#include "framebuffer.h"
+
+
+Framebuffer::~Framebuffer()
+{
+    Close();
+}
+
+bool Framebuffer::Open(const std::string& device)
+{
+    Close();
+    this->device = device;
+
+    dev = FbDevice::Create(device);
+    if (dev == nullptr) {
+        return false;
+    }
+    if (!dev->Open()) {
+        gLogger.log("Framebuffer: cannot open ", device);
+        dev.reset();
+        return false;
+    }
+
+    if (!mapScreen()) {
+        Close();
+        return false;
+    }
+
+    return true;
+}
+
+void Framebuffer::Close()
+{
+    unmapScreen();
+    dev.reset();
+}
+
+bool Framebuffer::Refresh()
+{
+    if (dev == nullptr) {
+        return Open(device);
+    }
+
+    fb_var_screeninfo now{};
+    fb_fix_screeninfo fix{};
+    if (!dev->ReadInfo(now, fix)) {
+        gLogger.log("Framebuffer: FBIOGET_VSCREENINFO failed on ", device);
+        return false;
+    }
+
+    if (isOpen() && sameMode(now, vinfo)) {
+        tiles.Invalidate(); // explicit refresh: rewrite everything next frame
+        return true; // nothing changed - keep the mapping
+    }
+
+    gLogger.log("Framebuffer: mode changed on ", device, ", re-mapping");
+    unmapScreen();
+    return mapScreen();
+}
+
+bool Framebuffer::mapScreen()
+{
+    if (!dev->ReadInfo(vinfo, finfo))
+    {
+        gLogger.log("Framebuffer: cannot read screen info from ", device);
+        return false;
+    }
+
+    mapLen = (size_t)vinfo.yres_virtual * finfo.line_length;
+
+    pixels = dev->Map(mapLen);
+    if (pixels == nullptr) {
+        gLogger.log("Framebuffer: mmap of ", mapLen, " bytes failed on ", device);
+        mapLen = 0;
+        return false;
+    }
+
+    setupPages();
+    resetTiles();
+
+    gLogger.log("Framebuffer: ", device, " mapped, xres=", vinfo.xres, " yres=", vinfo.yres,
+                " xres_virtual=", vinfo.xres_virtual, " yres_virtual=", vinfo.yres_virtual,
+                " bits_per_pixel=", vinfo.bits_per_pixel,
+                " line_length=", finfo.line_length, " smem_len=", finfo.smem_len,
+                doubleBuffered ? ", page flipping" : ", single buffered");
+    return true;
+}
+
+void Framebuffer::setupPages()
+{
+    doubleBuffered = vinfo.yres > 0 && vinfo.yres_virtual >= 2 * vinfo.yres;
+    vsyncWorks = true;
+
+    // render into whichever page is not on screen right now
+    unsigned frontPage = vinfo.yres > 0 ? vinfo.yoffset / vinfo.yres : 0;
+    backPage = frontPage == 0 ? 1 : 0;
+}
+
+void Framebuffer::resetTiles()
+{
+    // whole-byte pixels only; the diff buffers cost two frames of RAM
+    int bpp = vinfo.bits_per_pixel % 8 == 0 ? vinfo.bits_per_pixel / 8 : 0;
+    if (dirtyTiles && isOpen() && bpp > 0) {
+        tiles.Reset(vinfo.xres, vinfo.yres, bpp);
+    } else {
+        tiles.Reset(0, 0, 0);
+    }
+}
+
+void Framebuffer::SetDirtyTiles(bool on)
+{
+    if (on != dirtyTiles) {
+        dirtyTiles = on;
+        resetTiles();
+    }
+}
+
+uint8_t* Framebuffer::DrawBuffer()
+{
+    uint8_t* frame = tiles.Frame();
+    return frame != nullptr ? frame : BackBuffer();
+}
+
+uint32_t Framebuffer::DrawPitch() const
+{
+    return tiles.Pitch() > 0 ? (uint32_t)tiles.Pitch() : finfo.line_length;
+}
+
+uint8_t* Framebuffer::BackBuffer() const
+{
+    unsigned row = doubleBuffered ? backPage * vinfo.yres : vinfo.yoffset;
+    return pixels + (size_t)row * finfo.line_length;
+}
+
+uint8_t* Framebuffer::FrontBuffer() const
+{
+    return pixels + (size_t)vinfo.yoffset * finfo.line_length;
+}
+
+bool Framebuffer::Flip()
+{
+    return flip(true);
+}
+
+bool Framebuffer::FlipBackBuffer()
+{
+    tiles.Invalidate(); // next Flip() writes every tile
+    return flip(false);
+}
+
+bool Framebuffer::flip(bool commitTiles)
+{
+    if (!isOpen()) {
+        return true;
+    }
+    mark(PipelineStage::Converted);
+
+    // a page last got the frame before last when flipping - the diff covers both
+    if (commitTiles && tiles.Frame() != nullptr) {
+        tiles.Commit(BackBuffer(), finfo.line_length, doubleBuffered ? 2 : 1, pool);
+    }
+    mark(PipelineStage::Written);
+
+    if (!doubleBuffered) {
+        mark(PipelineStage::Presented); // drawn into the visible page
+        dev->FrameShown(pixels, vinfo.yoffset);
+        return true;
+    }
+
+    auto t0 = std::chrono::steady_clock::now();
+
+    if (vsyncWorks) 
+    {
+        if (!dev->WaitForVsync()) {
+            LOGW("Framebuffer: FBIO_WAITFORVSYNC not supported on ", device, ", panning unsynchronised");
+            vsyncWorks = false;
+        }
+    }
+
+    fb_var_screeninfo pan = vinfo;
+    pan.xoffset = 0;
+    pan.yoffset = backPage * vinfo.yres;
+
+    if (!dev->Pan(pan))
+    {
+        // driver reports the room but can't pan: show this frame, then stay single buffered
+        LOGW("Framebuffer: FBIOPAN_DISPLAY failed on ", device, ", falling back to single buffer");
+        uint8_t* back = BackBuffer();
+        doubleBuffered = false;
+        memcpy(BackBuffer(), back, (size_t)vinfo.yres * finfo.line_length);
+        return false;
+    }
+
+    vinfo.xoffset = pan.xoffset;
+    vinfo.yoffset = pan.yoffset;
+    backPage = backPage == 0 ? 1 : 0;
+    mark(PipelineStage::Presented);
+    dev->FrameShown(pixels, vinfo.yoffset);
+
+    auto us = (uint64_t)std::chrono::duration_cast<std::chrono::microseconds>(
+                  std::chrono::steady_clock::now() - t0).count();
+    flipStats.flips++;
+    flipStats.lastUs = us;
+    flipStats.totalUs += us;
+    if (us > flipStats.maxUs) flipStats.maxUs = us;
+
+    return true;
+}
+
+void Framebuffer::unmapScreen()
+{
+    if (pixels != nullptr) {
+        dev->Unmap(pixels, mapLen);
+        pixels = nullptr;
+        mapLen = 0;
+    }
+    tiles.Reset(0, 0, 0);
+}
+
+//static
+bool Framebuffer::sameMode(const fb_var_screeninfo& a, const fb_var_screeninfo& b)
+{
+    return a.xres == b.xres && a.yres == b.yres &&
+           a.xres_virtual == b.xres_virtual && a.yres_virtual == b.yres_virtual &&
+           a.bits_per_pixel == b.bits_per_pixel &&
+           a.red.offset == b.red.offset && a.green.offset == b.green.offset &&
+           a.blue.offset == b.blue.offset;
+}
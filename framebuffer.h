@@ -0,0 +1,81 @@
+#pragma once
+
+#include <linux/fb.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include "dirty_tiles.h"
+#include "fb_device.h"
+#include "stage_metrics.h"
+
+//-------------------------------------------------------------------
+//* fbdev mapping - opened and mmapped once, screen info cached
+class Framebuffer {
+public:
+    Framebuffer() = default;
+    ~Framebuffer();
+
+    Framebuffer(const Framebuffer&) = delete;
+    Framebuffer& operator=(const Framebuffer&) = delete;
+
+    bool Open(const std::string& device = "/dev/fb0"); // "/dev/fbN" or "virtual:..." (FbDevice::Create)
+    void Close();
+    bool Refresh(); // re-read mode, re-map only if it changed
+    bool isOpen() const { return pixels != nullptr; }
+
+    struct FlipStats {
+        uint64_t flips = 0;
+        uint64_t lastUs = 0;  // vsync wait + pan of the latest flip
+        uint64_t maxUs = 0;
+        uint64_t totalUs = 0;
+    };
+
+    uint8_t* Pixels() const { return pixels; }
+    uint8_t* BackBuffer() const; // page to render into (the visible one when single buffered)
+    uint8_t* FrontBuffer() const; // page on screen now - drawing here shows up immediately
+    bool Flip(); // write out the drawn frame, wait for vsync, pan to the back page
+    bool FlipBackBuffer(); // frame was drawn straight into BackBuffer(): no diff, the shadow is stale
+    bool isDoubleBuffered() const { return doubleBuffered; }
+    bool isVsynced() const { return doubleBuffered && vsyncWorks; } // Flip() returns on the vsync
+    FlipStats GetFlipStats() const { return flipStats; }
+    size_t Size() const { return mapLen; }
+    const fb_var_screeninfo& VInfo() const { return vinfo; }
+    const fb_fix_screeninfo& FInfo() const { return finfo; }
+
+    // Dirty tiles: frames are drawn into RAM and only changed tiles reach the fb at Flip()
+    void SetDirtyTiles(bool on);
+    void SetWorkerPool(WorkerPool* workers) { pool = workers; } // splits the diff + copy, nullptr = inline
+    uint8_t* DrawBuffer(); // where the next frame goes: RAM copy or BackBuffer()
+    uint32_t DrawPitch() const;
+    void InvalidateTiles() { tiles.Invalidate(); } // pages were drawn behind the diff's back
+    DirtyTiles::Stats GetDirtyStats() const { return tiles.GetStats(); }
+
+    void SetStageClock(StageClock* clock) { stages = clock; } // Flip() marks converted/written/presented
+
+private:
+    bool mapScreen();
+    void unmapScreen();
+    void setupPages();
+    void resetTiles();
+    bool flip(bool commitTiles);
+    void mark(PipelineStage stage) { if (stages) stages->Mark(stage); }
+    static bool sameMode(const fb_var_screeninfo& a, const fb_var_screeninfo& b);
+
+    std::string device{"/dev/fb0"};
+    std::unique_ptr<FbDevice> dev; // fbdev or virtual
+    uint8_t* pixels{nullptr};
+    size_t mapLen{0};
+    fb_var_screeninfo vinfo{};
+    fb_fix_screeninfo finfo{};
+    bool doubleBuffered{false}; // yres_virtual >= 2 * yres and panning works
+    bool vsyncWorks{true};
+    unsigned backPage{0};
+    FlipStats flipStats;
+    bool dirtyTiles{false};
+    DirtyTiles tiles; // shadow of the last frame, sized to the mode
+    WorkerPool* pool{nullptr};
+    StageClock* stages{nullptr};
+};
@@ -0,0 +1,208 @@
+// sudo apt install libsdl2-dev libsdl2-image-dev
+
+#include <SDL2/SDL.h>
+#include <SDL2/SDL_image.h>
+
+#include <sys/stat.h>
+
+#include "logger.h"
+extern Logger gLogger; // declare external logger instance
+
+#include "image_cache.h"
+
+
+ImageCache::ImageCache(size_t budgetBytes)
+    : budget(budgetBytes)
+{
+}
+
+void ImageCache::SetBudget(size_t budgetBytes)
+{
+    std::lock_guard<std::mutex> lock(mtx);
+    budget = budgetBytes;
+    evictToBudget();
+}
+
+size_t ImageCache::GetBudget() const
+{
+    std::lock_guard<std::mutex> lock(mtx);
+    return budget;
+}
+
+//static
+SurfacePtr ImageCache::MakeShared(SDL_Surface* surface)
+{
+    if (surface == nullptr) {
+        return nullptr;
+    }
+    return SurfacePtr(surface, [](SDL_Surface* s) { SDL_FreeSurface(s); });
+}
+
+//static
+size_t ImageCache::SurfaceBytes(const SDL_Surface* surface)
+{
+    return surface ? (size_t)surface->pitch * (size_t)surface->h : 0;
+}
+
+//static
+int64_t ImageCache::fileMTime(const std::string& path)
+{
+    struct stat st;
+    if (stat(path.c_str(), &st) != 0) {
+        return -1;
+    }
+    return (int64_t)st.st_mtim.tv_sec * 1000000000LL + st.st_mtim.tv_nsec;
+}
+
+SurfacePtr ImageCache::Load(const std::string& path)
+{
+    int64_t mtime = fileMTime(path);
+
+    if (auto cached = lookup(path, mtime)) {
+        return cached;
+    }
+
+    SurfacePtr surface = MakeShared(IMG_Load(path.c_str()));
+    if (surface == nullptr) {
+        LOGW("Unable to load image ", path, "! IMG_Error: ", IMG_GetError());
+        return nullptr;
+    }
+
+    insert(path, surface, mtime);
+    return surface;
+}
+
+bool ImageCache::Warm(const std::string& path)
+{
+    int64_t mtime = fileMTime(path);
+    if (mtime < 0 || contains(path, mtime) || GetBudget() == 0) {
+        return false;
+    }
+
+    SurfacePtr surface = MakeShared(IMG_Load(path.c_str()));
+    if (surface == nullptr) {
+        LOGW("Prefetch: unable to load image ", path, "! IMG_Error: ", IMG_GetError());
+        return false;
+    }
+
+    insert(path, surface, mtime);
+
+    std::lock_guard<std::mutex> lock(mtx);
+    stats.warmed++;
+    return true;
+}
+
+SurfacePtr ImageCache::Cached(const std::string& key, int64_t version)
+{
+    return lookup(key, version);
+}
+
+SurfacePtr ImageCache::Decode(const std::string& key, const void* data, size_t size, int64_t version)
+{
+    SDL_RWops* rw = SDL_RWFromConstMem(data, (int)size); // no copy, no temp file
+    SurfacePtr surface = MakeShared(rw ? IMG_Load_RW(rw, 1) : nullptr);
+    if (surface == nullptr) {
+        LOGW("Unable to decode image ", key, "! IMG_Error: ", IMG_GetError());
+        return nullptr;
+    }
+
+    insert(key, surface, version);
+    return surface;
+}
+
+void ImageCache::Invalidate(const std::string& path)
+{
+    std::lock_guard<std::mutex> lock(mtx);
+
+    auto it = index.find(path);
+    if (it != index.end()) {
+        stats.bytes -= it->second->bytes;
+        lru.erase(it->second);
+        index.erase(it);
+    }
+}
+
+void ImageCache::Clear()
+{
+    std::lock_guard<std::mutex> lock(mtx);
+    lru.clear();
+    index.clear();
+    stats.bytes = 0;
+}
+
+ImageCache::Stats ImageCache::GetStats() const
+{
+    std::lock_guard<std::mutex> lock(mtx);
+    Stats s = stats;
+    s.entries = lru.size();
+    return s;
+}
+
+SurfacePtr ImageCache::lookup(const std::string& key, int64_t mtime)
+{
+    std::lock_guard<std::mutex> lock(mtx);
+
+    auto it = index.find(key);
+    if (it == index.end()) {
+        stats.misses++;
+        return nullptr;
+    }
+
+    if (it->second->mtime != mtime) // file replaced on disk - decode again
+    {
+        stats.misses++;
+        stats.bytes -= it->second->bytes;
+        lru.erase(it->second);
+        index.erase(it);
+        return nullptr;
+    }
+
+    stats.hits++;
+    lru.splice(lru.begin(), lru, it->second);
+    return it->second->surface;
+}
+
+bool ImageCache::contains(const std::string& key, int64_t mtime) const
+{
+    std::lock_guard<std::mutex> lock(mtx);
+
+    auto it = index.find(key);
+    return it != index.end() && it->second->mtime == mtime;
+}
+
+void ImageCache::insert(const std::string& key, SurfacePtr surface, int64_t mtime)
+{
+    size_t bytes = SurfaceBytes(surface.get());
+
+    std::lock_guard<std::mutex> lock(mtx);
+
+    if (bytes > budget) {
+        return; // would not fit even alone (also covers budget 0 = off)
+    }
+
+    auto it = index.find(key);
+    if (it != index.end()) {
+        stats.bytes -= it->second->bytes;
+        lru.erase(it->second);
+        index.erase(it);
+    }
+
+    lru.push_front(Entry{key, std::move(surface), bytes, mtime});
+    index[key] = lru.begin();
+    stats.bytes += bytes;
+
+    evictToBudget();
+}
+
+// caller holds mtx
+void ImageCache::evictToBudget()
+{
+    while (stats.bytes > budget && !lru.empty())
+    {
+        Entry& victim = lru.back();
+        stats.bytes -= victim.bytes;
+        stats.evictions++;
+        index.erase(victim.key);
+        lru.pop_back();
+    }
+}
@@ -0,0 +1,71 @@
+// sudo apt install libsdl2-dev libsdl2-image-dev
+
+#pragma once
+
+#include <SDL2/SDL.h>
+
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+// Decoded surfaces are shared: an entry evicted while still on screen stays alive
+using SurfacePtr = std::shared_ptr<SDL_Surface>;
+
+//-------------------------------------------------------------------
+//* Decoded image cache - LRU, bounded by a byte budget, mtime checked
+class ImageCache {
+public:
+    struct Stats {
+        uint64_t hits = 0;
+        uint64_t misses = 0;
+        uint64_t evictions = 0;
+        uint64_t warmed = 0; // decoded ahead of time by Warm()
+        size_t bytes = 0;    // decoded bytes held
+        size_t entries = 0;
+    };
+
+    explicit ImageCache(size_t budgetBytes = 0); // 0 = caching off
+
+    void SetBudget(size_t budgetBytes);
+    size_t GetBudget() const;
+
+    SurfacePtr Load(const std::string& path); // cached or IMG_Load, nullptr on failure
+    bool Warm(const std::string& path); // decode ahead of use, false if cached/missing/no room
+    bool Has(const std::string& path) const { return contains(path, fileMTime(path)); } // no stats
+
+    // encoded bytes from elsewhere (redis), keyed by the caller; version stands in for the mtime:
+    // an entry decoded under another version misses
+    SurfacePtr Cached(const std::string& key, int64_t version); // nullptr on miss
+    SurfacePtr Decode(const std::string& key, const void* data, size_t size, int64_t version); // IMG_Load_RW from memory
+    void Invalidate(const std::string& path);
+    void Clear();
+
+    Stats GetStats() const;
+
+    static SurfacePtr MakeShared(SDL_Surface* surface); // owns, frees with SDL_FreeSurface
+    static size_t SurfaceBytes(const SDL_Surface* surface);
+
+private:
+    struct Entry {
+        std::string key;
+        SurfacePtr surface;
+        size_t bytes;
+        int64_t mtime; // ns, file modification time at decode (or the caller's version)
+    };
+
+    SurfacePtr lookup(const std::string& key, int64_t mtime); // hit moves entry to front
+    bool contains(const std::string& key, int64_t mtime) const; // no stats, no reordering
+    void insert(const std::string& key, SurfacePtr surface, int64_t mtime);
+    void evictToBudget();
+
+    static int64_t fileMTime(const std::string& path); // -1 if missing
+
+    std::list<Entry> lru; // front = most recently used
+    std::unordered_map<std::string, std::list<Entry>::iterator> index;
+    size_t budget;
+    Stats stats;
+    mutable std::mutex mtx;
+};
@@ -0,0 +1,340 @@
+#include <algorithm>
+#include <csetjmp>
+#include <cstdio>
+#include <cstring>
+
+#if defined(HAVE_LIBPNG)
+#include <png.h>
+#endif
+#if defined(HAVE_LIBJPEG)
+#include <jpeglib.h>
+#endif
+
+#include "image_decode.h"
+
+struct DirectDecoder::Input {
+    FILE* fp = nullptr;
+    const uint8_t* data = nullptr;
+    size_t size = 0;
+    size_t pos = 0;
+
+    size_t read(void* out, size_t n)
+    {
+        if (fp != nullptr) {
+            return fread(out, 1, n, fp);
+        }
+        n = std::min(n, size - pos);
+        memcpy(out, data + pos, n);
+        pos += n;
+        return n;
+    }
+
+    void rewind()
+    {
+        if (fp != nullptr) {
+            fseek(fp, 0, SEEK_SET);
+        }
+        pos = 0;
+    }
+};
+
+//static
+bool DirectDecoder::Available()
+{
+#if defined(HAVE_LIBPNG) || defined(HAVE_LIBJPEG)
+    return true;
+#else
+    return false;
+#endif
+}
+
+DirectDecoder::Result DirectDecoder::DecodeFile(const std::string& path, const Target& target)
+{
+    FILE* fp = fopen(path.c_str(), "rbe");
+    if (fp == nullptr) {
+        stats.failed++;
+        return Result::Failed;
+    }
+
+    Input in;
+    in.fp = fp;
+    Result result = decode(in, target);
+    fclose(fp);
+    return result;
+}
+
+DirectDecoder::Result DirectDecoder::DecodeMemory(const void* data, size_t size, const Target& target)
+{
+    Input in;
+    in.data = (const uint8_t*)data;
+    in.size = size;
+    return decode(in, target);
+}
+
+DirectDecoder::Result DirectDecoder::decode(Input& in, const Target& target)
+{
+    uint8_t sig[8] = {};
+    size_t n = in.read(sig, sizeof(sig));
+    in.rewind();
+
+    Result result = Result::Unsupported;
+    if (target.pixels != nullptr && DstBytesPerPixel(target.format) > 0)
+    {
+#if defined(HAVE_LIBPNG)
+        if (n >= 8 && png_sig_cmp(sig, 0, 8) == 0) {
+            result = decodePng(in, target);
+        }
+#endif
+#if defined(HAVE_LIBJPEG)
+        if (n >= 2 && sig[0] == 0xFF && sig[1] == 0xD8) {
+            result = decodeJpeg(in, target);
+        }
+#endif
+    }
+    (void)n;
+
+    if (result == Result::Done) stats.decoded++;
+    else if (result == Result::Unsupported) stats.unsupported++;
+    else stats.failed++;
+    return result;
+}
+
+//static
+bool DirectDecoder::place(int width, int height, const Target& target, ScaleRect& srcRect, ScaleRect& dstRect)
+{
+    ComputePlacement(width, height, target.box, target.mode, srcRect, dstRect);
+    return dstRect.w > 0 && dstRect.h > 0 && srcRect.w == dstRect.w && srcRect.h == dstRect.h;
+}
+
+//static
+void DirectDecoder::clearOutside(const Target& target, const ScaleRect& dstRect)
+{
+    int bpp = DstBytesPerPixel(target.format);
+    for (int y = 0; y < target.height; y++) {
+        uint8_t* line = target.pixels + (size_t)y * target.pitch;
+        if (y < dstRect.y || y >= dstRect.y + dstRect.h) {
+            memset(line, 0, (size_t)target.width * bpp);
+            continue;
+        }
+        memset(line, 0, (size_t)dstRect.x * bpp);
+        memset(line + (dstRect.x + dstRect.w) * bpp, 0, (size_t)(target.width - dstRect.x - dstRect.w) * bpp);
+    }
+}
+
+//static
+void DirectDecoder::rowDone(const Target& target, int rows, int total)
+{
+    if (target.progress && (rows == 1 || rows % kProgressRows == 0 || rows == total)) {
+        target.progress(rows);
+    }
+}
+
+#if defined(HAVE_LIBPNG)
+//-------------------------------------------------------------------
+//* libpng: every colour type expanded to R,G,B,A bytes, one row at a time
+DirectDecoder::Result DirectDecoder::decodePng(Input& in, const Target& target)
+{
+    png_structp png = png_create_read_struct(PNG_LIBPNG_VER_STRING, nullptr,
+                                             [](png_structp p, png_const_charp) { png_longjmp(p, 1); },
+                                             [](png_structp, png_const_charp) {}); // iCCP chatter etc.
+    png_infop info = png ? png_create_info_struct(png) : nullptr;
+    if (info == nullptr) {
+        png_destroy_read_struct(&png, nullptr, nullptr);
+        return Result::Failed;
+    }
+
+    // no objects with destructors between here and the end: errors longjmp back
+    if (setjmp(png_jmpbuf(png))) {
+        png_destroy_read_struct(&png, &info, nullptr);
+        return Result::Failed;
+    }
+
+    png_set_read_fn(png, &in, [](png_structp p, png_bytep out, png_size_t n) {
+        if (((Input*)png_get_io_ptr(p))->read(out, n) != n) {
+            png_error(p, "truncated");
+        }
+    });
+    png_read_info(png, info);
+
+    png_uint_32 width = 0, height = 0;
+    int depth = 0, colorType = 0, interlace = 0;
+    png_get_IHDR(png, info, &width, &height, &depth, &colorType, &interlace, nullptr, nullptr);
+
+    ScaleRect srcRect, dstRect;
+    ConvertRowFn convert = GetRowConverter(SrcPixelFormat::RGBA8888, target.format, target.swapRB);
+    if (interlace != PNG_INTERLACE_NONE || convert == nullptr || !place(width, height, target, srcRect, dstRect)) {
+        png_destroy_read_struct(&png, &info, nullptr);
+        return Result::Unsupported; // interlaced needs the whole image, scaling needs the surface path
+    }
+
+    if (depth == 16) png_set_strip_16(png);
+    if (colorType == PNG_COLOR_TYPE_PALETTE) png_set_palette_to_rgb(png);
+    if (colorType == PNG_COLOR_TYPE_GRAY && depth < 8) png_set_expand_gray_1_2_4_to_8(png);
+    if (png_get_valid(png, info, PNG_INFO_tRNS)) png_set_tRNS_to_alpha(png);
+    if (colorType == PNG_COLOR_TYPE_GRAY || colorType == PNG_COLOR_TYPE_GRAY_ALPHA) png_set_gray_to_rgb(png);
+    png_set_filler(png, 0xFF, PNG_FILLER_AFTER); // RGB -> RGBX, RGBA unchanged
+    png_read_update_info(png, info);
+
+    row.resize(png_get_rowbytes(png, info));
+    if (!target.progress) {
+        clearOutside(target, dstRect);
+    }
+
+    int bpp = DstBytesPerPixel(target.format);
+    uint8_t* dst = target.pixels + (size_t)dstRect.y * target.pitch + (size_t)dstRect.x * bpp;
+    for (int y = 0; y < srcRect.y + srcRect.h; ++y)
+    {
+        png_read_row(png, row.data(), nullptr);
+        if (y >= srcRect.y) {
+            convert(row.data() + (size_t)srcRect.x * 4, dst + (size_t)(y - srcRect.y) * target.pitch, dstRect.w);
+            rowDone(target, y - srcRect.y + 1, dstRect.h);
+        }
+    }
+
+    png_destroy_read_struct(&png, &info, nullptr); // rows below the crop are never decoded
+    if (target.progress) {
+        clearOutside(target, dstRect);
+    }
+    return Result::Done;
+}
+#endif
+
+#if defined(HAVE_LIBJPEG)
+//-------------------------------------------------------------------
+//* libjpeg(-turbo): RGBX output when the extensions are there, packed RGB otherwise
+namespace {
+
+struct JpegError {
+    jpeg_error_mgr mgr;
+    jmp_buf jump;
+};
+
+// jpeg_stdio_src/jpeg_mem_src equivalent over Input, so both sources share one path
+struct JpegSource {
+    jpeg_source_mgr mgr;
+    void* input;
+    size_t (*read)(void* input, void* out, size_t n);
+    JOCTET buffer[16384];
+};
+
+} // namespace
+
+DirectDecoder::Result DirectDecoder::decodeJpeg(Input& in, const Target& target)
+{
+    jpeg_decompress_struct cinfo{};
+    JpegError err;
+    cinfo.err = jpeg_std_error(&err.mgr);
+    err.mgr.error_exit = [](j_common_ptr c) { longjmp(((JpegError*)c->err)->jump, 1); };
+    err.mgr.output_message = [](j_common_ptr) {};
+
+    // no objects with destructors between here and the end: errors longjmp back
+    if (setjmp(err.jump)) {
+        jpeg_destroy_decompress(&cinfo);
+        return Result::Failed;
+    }
+    jpeg_create_decompress(&cinfo);
+
+    JpegSource src;
+    src.input = &in;
+    src.read = [](void* input, void* out, size_t n) { return ((Input*)input)->read(out, n); };
+    src.mgr.next_input_byte = nullptr;
+    src.mgr.bytes_in_buffer = 0;
+    src.mgr.init_source = [](j_decompress_ptr) {};
+    src.mgr.term_source = [](j_decompress_ptr) {};
+    src.mgr.resync_to_restart = jpeg_resync_to_restart;
+    src.mgr.fill_input_buffer = [](j_decompress_ptr c) -> boolean {
+        JpegSource* s = (JpegSource*)c->src;
+        size_t n = s->read(s->input, s->buffer, sizeof(s->buffer));
+        if (n == 0) {
+            // truncated file: fake an EOI, libjpeg shows what it has
+            s->buffer[0] = 0xFF;
+            s->buffer[1] = JPEG_EOI;
+            n = 2;
+        }
+        s->mgr.next_input_byte = s->buffer;
+        s->mgr.bytes_in_buffer = n;
+        return TRUE;
+    };
+    src.mgr.skip_input_data = [](j_decompress_ptr c, long n) {
+        while (n > 0) {
+            if (c->src->bytes_in_buffer == 0) {
+                c->src->fill_input_buffer(c);
+            }
+            long step = std::min(n, (long)c->src->bytes_in_buffer);
+            c->src->next_input_byte += step;
+            c->src->bytes_in_buffer -= step;
+            n -= step;
+        }
+    };
+    cinfo.src = &src.mgr;
+
+    jpeg_read_header(&cinfo, TRUE);
+
+#if defined(JCS_EXTENSIONS)
+    cinfo.out_color_space = JCS_EXT_RGBX;
+    SrcPixelFormat srcFormat = SrcPixelFormat::RGBA8888;
+#else
+    cinfo.out_color_space = JCS_RGB;
+    SrcPixelFormat srcFormat = SrcPixelFormat::RGB888;
+#endif
+    int srcBpp = SrcBytesPerPixel(srcFormat);
+
+    ScaleRect srcRect, dstRect;
+    ConvertRowFn convert = GetRowConverter(srcFormat, target.format, target.swapRB);
+    if (cinfo.jpeg_color_space == JCS_CMYK || cinfo.jpeg_color_space == JCS_YCCK || convert == nullptr ||
+        !place(cinfo.image_width, cinfo.image_height, target, srcRect, dstRect)) {
+        jpeg_destroy_decompress(&cinfo);
+        return Result::Unsupported;
+    }
+
+    // progressive file on screen: a coarse first scan of the whole picture, then the final pass.
+    // Two output passes, not one per scan - each pass costs about a full baseline decode.
+    bool preview = target.progress && jpeg_has_multiple_scans(&cinfo);
+    cinfo.buffered_image = preview ? TRUE : FALSE;
+
+    jpeg_start_decompress(&cinfo);
+    row.resize((size_t)cinfo.output_width * srcBpp);
+    if (!target.progress) {
+        clearOutside(target, dstRect);
+    }
+
+    int bpp = DstBytesPerPixel(target.format);
+    uint8_t* dst = target.pixels + (size_t)dstRect.y * target.pitch + (size_t)dstRect.x * bpp;
+    JSAMPROW line = row.data();
+    auto outputRows = [&]() {
+        for (int y = 0; y < srcRect.y + srcRect.h; ++y)
+        {
+            jpeg_read_scanlines(&cinfo, &line, 1);
+            if (y >= srcRect.y) {
+                convert(line + (size_t)srcRect.x * srcBpp, dst + (size_t)(y - srcRect.y) * target.pitch, dstRect.w);
+                rowDone(target, y - srcRect.y + 1, dstRect.h);
+            }
+        }
+    };
+
+    if (preview)
+    {
+        jpeg_start_output(&cinfo, 1); // reads input up to the end of the first scan
+        outputRows();
+        jpeg_finish_output(&cinfo);
+
+        int status;
+        do {
+            status = jpeg_consume_input(&cinfo);
+        } while (status != JPEG_REACHED_EOI && status != JPEG_SUSPENDED);
+
+        jpeg_start_output(&cinfo, cinfo.input_scan_number);
+        outputRows();
+        jpeg_finish_output(&cinfo);
+    }
+    else {
+        outputRows();
+    }
+
+    jpeg_destroy_decompress(&cinfo); // aborts; rows below the crop are never decoded
+    if (target.progress) {
+        clearOutside(target, dstRect);
+    }
+    return Result::Done;
+}
+#endif
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "image_scale.h"
+#include "pixel_convert.h"
+
+//-------------------------------------------------------------------
+//* PNG/JPEG decoded row by row straight into a scanout buffer - no SDL_Surface, no full-frame
+// RGBA copy, one reused scanline. Built with libpng (HAVE_LIBPNG) / libjpeg (HAVE_LIBJPEG).
+// Only for images placed 1:1 (ScaleMode none/center or already panel-sized): anything that
+// needs resampling returns Unsupported and goes through the surface path.
+class DirectDecoder {
+public:
+    enum class Result { Done, Unsupported, Failed };
+
+    struct Target {
+        uint8_t* pixels = nullptr; // mapped fb page, fb draw buffer, transition frame...
+        int pitch = 0;
+        int width = 0;
+        int height = 0;
+        DstPixelFormat format = DstPixelFormat::Unknown;
+        ScaleRect box;  // ImageScaler::TargetBox
+        ScaleMode mode = ScaleMode::Fit;
+        bool swapRB = false;
+
+        // progressive display: pixels is on screen, called as rows land (rows = done so far).
+        // Progressive JPEGs then show a coarse first scan of the whole picture before the final pass,
+        // and the area outside the image is cleared last so the old picture stays until it's covered.
+        std::function<void(int rows)> progress;
+    };
+
+    struct Stats {
+        uint64_t decoded = 0;
+        uint64_t unsupported = 0; // needed scaling, interlaced, not built in...
+        uint64_t failed = 0;
+    };
+
+    Result DecodeFile(const std::string& path, const Target& target);
+    Result DecodeMemory(const void* data, size_t size, const Target& target);
+
+    static bool Available(); // built with at least one of the libraries
+
+    Stats GetStats() const { return stats; }
+
+private:
+    struct Input; // FILE* or memory
+
+    Result decode(Input& in, const Target& target);
+    Result decodePng(Input& in, const Target& target);
+    Result decodeJpeg(Input& in, const Target& target);
+
+    // placement of a width x height image, false if it would need resampling
+    static bool place(int width, int height, const Target& target, ScaleRect& srcRect, ScaleRect& dstRect);
+    static void clearOutside(const Target& target, const ScaleRect& dstRect);
+    static void rowDone(const Target& target, int rows, int total); // progress every kProgressRows
+
+    static constexpr int kProgressRows = 32;
+
+    std::vector<uint8_t> row; // one decoded scanline
+    Stats stats;
+};
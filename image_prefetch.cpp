@@ -0,0 +1,125 @@
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include "logger.h"
+extern Logger gLogger; // declare external logger instance
+
+#include "image_prefetch.h"
+
+
+ImagePrefetcher::ImagePrefetcher(ImageCache& cache)
+    : cache(cache)
+{
+}
+
+ImagePrefetcher::~ImagePrefetcher()
+{
+    Stop();
+}
+
+void ImagePrefetcher::Start(int threads)
+{
+    std::lock_guard<std::mutex> lifecycle(lifecycleMtx);
+    if (!workers.empty() || threads <= 0) {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        stop = false;
+    }
+
+    for (int i = 0; i < threads; ++i) {
+        workers.emplace_back(&ImagePrefetcher::workerLoop, this);
+    }
+    running.store(true, std::memory_order_release);
+
+    gLogger.log("Prefetch: started ", threads, " decode worker(s)");
+}
+
+void ImagePrefetcher::Stop()
+{
+    std::lock_guard<std::mutex> lifecycle(lifecycleMtx);
+    running.store(false, std::memory_order_release);
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        stop = true;
+        pending.clear();
+    }
+    cvWork.notify_all();
+
+    for (auto& t : workers) {
+        if (t.joinable()) {
+            t.join();
+        }
+    }
+    workers.clear();
+}
+
+void ImagePrefetcher::Schedule(const std::vector<std::string>& paths)
+{
+    if (!isRunning()) {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        stats.dropped += pending.size(); // old predictions are stale now
+        pending.assign(paths.begin(), paths.end());
+    }
+    cvWork.notify_all();
+}
+
+void ImagePrefetcher::Claim(const std::string& path)
+{
+    std::unique_lock<std::mutex> lock(mtx);
+
+    // the real request wins: nothing new gets started behind it
+    stats.dropped += pending.size();
+    pending.clear();
+
+    // already being decoded - wait for it instead of decoding twice
+    cvDone.wait(lock, [&] { return stop || inFlight.count(path) == 0; });
+}
+
+ImagePrefetcher::Stats ImagePrefetcher::GetStats() const
+{
+    std::lock_guard<std::mutex> lock(mtx);
+    return stats;
+}
+
+void ImagePrefetcher::workerLoop()
+{
+    // background priority - the render thread keeps the CPU when it needs it
+    setpriority(PRIO_PROCESS, (id_t)syscall(SYS_gettid), 10);
+
+    while (true)
+    {
+        std::string path;
+        {
+            std::unique_lock<std::mutex> lock(mtx);
+            cvWork.wait(lock, [&] { return stop || !pending.empty(); });
+            if (stop) {
+                return;
+            }
+
+            path = pending.front();
+            pending.pop_front();
+            if (inFlight.count(path)) {
+                continue; // another worker has it
+            }
+            inFlight.insert(path);
+        }
+
+        bool decoded = cache.Warm(path);
+
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            inFlight.erase(path);
+            if (decoded) stats.decoded++;
+            else stats.skipped++;
+        }
+        cvDone.notify_all();
+    }
+}
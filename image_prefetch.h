@@ -0,0 +1,50 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+
+#include "image_cache.h"
+
+//-------------------------------------------------------------------
+//* Background decode workers - warm the image cache with predicted next images
+class ImagePrefetcher {
+public:
+    struct Stats {
+        uint64_t decoded = 0;  // surfaces put into the cache ahead of time
+        uint64_t skipped = 0;  // already cached / missing file
+        uint64_t dropped = 0;  // predictions discarded before a worker got to them
+    };
+
+    explicit ImagePrefetcher(ImageCache& cache);
+    ~ImagePrefetcher();
+
+    void Start(int threads); // may run on the SDL auto-init thread
+    void Stop();
+    bool isRunning() const { return running.load(std::memory_order_acquire); }
+
+    void Schedule(const std::vector<std::string>& paths); // replaces pending predictions
+    void Claim(const std::string& path); // foreground needs path now - prefetches yield
+
+    Stats GetStats() const;
+
+private:
+    void workerLoop();
+
+    ImageCache& cache;
+    std::mutex lifecycleMtx; // Start vs. Stop; workers is only touched under it
+    std::vector<std::thread> workers;
+    std::atomic<bool> running{false}; // set once workers exist - what Schedule and isRunning read
+    std::deque<std::string> pending;          // front = most likely next
+    std::unordered_set<std::string> inFlight; // being decoded by a worker
+    bool stop = false;
+    Stats stats;
+    mutable std::mutex mtx;
+    std::condition_variable cvWork;
+    std::condition_variable cvDone;
+};
@@ -0,0 +1,335 @@
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#if defined(__ARM_NEON)
+#include <arm_neon.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#include "image_scale.h"
+
+ScaleMode ScaleModeFromName(const std::string& name)
+{
+    if (name == "none") return ScaleMode::None;
+    if (name == "fill") return ScaleMode::Fill;
+    if (name == "stretch") return ScaleMode::Stretch;
+    if (name == "center") return ScaleMode::Center;
+    return ScaleMode::Fit;
+}
+
+ScaleFilter ScaleFilterFromName(const std::string& name)
+{
+    return name == "nearest" ? ScaleFilter::Nearest : ScaleFilter::Bilinear;
+}
+
+void ComputePlacement(int srcW, int srcH, const ScaleRect& box, ScaleMode mode,
+                      ScaleRect& srcRect, ScaleRect& dstRect)
+{
+    srcRect = {0, 0, srcW, srcH};
+    dstRect = box;
+
+    switch (mode)
+    {
+    case ScaleMode::None:
+        srcRect.w = dstRect.w = std::min(srcW, box.w);
+        srcRect.h = dstRect.h = std::min(srcH, box.h);
+        break;
+
+    case ScaleMode::Center:
+        srcRect.w = dstRect.w = std::min(srcW, box.w);
+        srcRect.h = dstRect.h = std::min(srcH, box.h);
+        srcRect.x = (srcW - srcRect.w) / 2;
+        srcRect.y = (srcH - srcRect.h) / 2;
+        dstRect.x = box.x + (box.w - dstRect.w) / 2;
+        dstRect.y = box.y + (box.h - dstRect.h) / 2;
+        break;
+
+    case ScaleMode::Fit:
+        if ((int64_t)srcW * box.h <= (int64_t)box.w * srcH) { // height limited
+            dstRect.h = box.h;
+            dstRect.w = std::max(1, (int)((int64_t)srcW * box.h / srcH));
+        } else {
+            dstRect.w = box.w;
+            dstRect.h = std::max(1, (int)((int64_t)srcH * box.w / srcW));
+        }
+        dstRect.x = box.x + (box.w - dstRect.w) / 2;
+        dstRect.y = box.y + (box.h - dstRect.h) / 2;
+        break;
+
+    case ScaleMode::Fill:
+        if ((int64_t)srcW * box.h > (int64_t)box.w * srcH) { // wider than the box: crop sides
+            srcRect.w = std::max(1, (int)((int64_t)srcH * box.w / box.h));
+            srcRect.x = (srcW - srcRect.w) / 2;
+        } else {
+            srcRect.h = std::max(1, (int)((int64_t)srcW * box.h / box.w));
+            srcRect.y = (srcH - srcRect.h) / 2;
+        }
+        break;
+
+    case ScaleMode::Stretch:
+        break;
+    }
+}
+
+namespace {
+
+inline uint8_t lerp8(int a, int b, int w) // w 0..256 towards b
+{
+    return (uint8_t)((a * (256 - w) + b * w + 128) >> 8);
+}
+
+//-------------------------------------------------------------------
+//* Vertical pass: two source rows -> one, byte-wise
+void lerpRow(const uint8_t* a, const uint8_t* b, int w, uint8_t* out, int bytes)
+{
+    int i = 0;
+#if defined(__ARM_NEON)
+    for (; i + 16 <= bytes; i += 16)
+    {
+        uint8x16_t va = vld1q_u8(a + i), vb = vld1q_u8(b + i);
+        uint16x8_t lo = vmulq_n_u16(vmovl_u8(vget_low_u8(va)), (uint16_t)(256 - w));
+        uint16x8_t hi = vmulq_n_u16(vmovl_u8(vget_high_u8(va)), (uint16_t)(256 - w));
+        lo = vmlaq_n_u16(lo, vmovl_u8(vget_low_u8(vb)), (uint16_t)w);
+        hi = vmlaq_n_u16(hi, vmovl_u8(vget_high_u8(vb)), (uint16_t)w);
+        vst1q_u8(out + i, vcombine_u8(vrshrn_n_u16(lo, 8), vrshrn_n_u16(hi, 8)));
+    }
+#elif defined(__SSE2__)
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i wb = _mm_set1_epi16((short)w), wa = _mm_set1_epi16((short)(256 - w));
+    const __m128i round = _mm_set1_epi16(128);
+    for (; i + 16 <= bytes; i += 16)
+    {
+        __m128i va = _mm_loadu_si128((const __m128i*)(a + i));
+        __m128i vb = _mm_loadu_si128((const __m128i*)(b + i));
+        __m128i lo = _mm_add_epi16(_mm_mullo_epi16(_mm_unpacklo_epi8(va, zero), wa),
+                                   _mm_mullo_epi16(_mm_unpacklo_epi8(vb, zero), wb));
+        __m128i hi = _mm_add_epi16(_mm_mullo_epi16(_mm_unpackhi_epi8(va, zero), wa),
+                                   _mm_mullo_epi16(_mm_unpackhi_epi8(vb, zero), wb));
+        lo = _mm_srli_epi16(_mm_add_epi16(lo, round), 8);
+        hi = _mm_srli_epi16(_mm_add_epi16(hi, round), 8);
+        _mm_storeu_si128((__m128i*)(out + i), _mm_packus_epi16(lo, hi));
+    }
+#endif
+    for (; i < bytes; ++i) {
+        out[i] = lerp8(a[i], b[i], w);
+    }
+}
+
+// 3-byte rows widened to 4 (alpha 255) on the way, blend in scalar
+void lerpRow3(const uint8_t* a, const uint8_t* b, int w, uint8_t* out, int pixels)
+{
+    for (int x = 0; x < pixels; ++x, a += 3, b += 3, out += 4) {
+        out[0] = lerp8(a[0], b[0], w);
+        out[1] = lerp8(a[1], b[1], w);
+        out[2] = lerp8(a[2], b[2], w);
+        out[3] = 0xFF;
+    }
+}
+
+//-------------------------------------------------------------------
+//* Horizontal pass: pixel pairs (i, i+1) of the blended row, weights from the table
+void hlerpRow(const uint8_t* row, const int32_t* xi, const uint16_t* xw, uint8_t* out, int width)
+{
+    int x = 0;
+#if defined(__ARM_NEON)
+    for (; x + 2 <= width; x += 2)
+    {
+        // [left, right] of each output pixel, times [256-w x4, w x4], halves summed
+        uint16x8_t p0 = vmovl_u8(vld1_u8(row + xi[x] * 4));
+        uint16x8_t p1 = vmovl_u8(vld1_u8(row + xi[x + 1] * 4));
+        uint16x8_t w0 = vcombine_u16(vdup_n_u16((uint16_t)(256 - xw[x])), vdup_n_u16(xw[x]));
+        uint16x8_t w1 = vcombine_u16(vdup_n_u16((uint16_t)(256 - xw[x + 1])), vdup_n_u16(xw[x + 1]));
+        p0 = vmulq_u16(p0, w0);
+        p1 = vmulq_u16(p1, w1);
+        uint16x8_t sum = vcombine_u16(vadd_u16(vget_low_u16(p0), vget_high_u16(p0)),
+                                      vadd_u16(vget_low_u16(p1), vget_high_u16(p1)));
+        vst1_u8(out + x * 4, vrshrn_n_u16(sum, 8));
+    }
+#elif defined(__SSE2__)
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i round = _mm_set1_epi16(128);
+    for (; x + 2 <= width; x += 2)
+    {
+        __m128i p0 = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i*)(row + xi[x] * 4)), zero);
+        __m128i p1 = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i*)(row + xi[x + 1] * 4)), zero);
+        __m128i w0 = _mm_unpacklo_epi64(_mm_set1_epi16((short)(256 - xw[x])), _mm_set1_epi16((short)xw[x]));
+        __m128i w1 = _mm_unpacklo_epi64(_mm_set1_epi16((short)(256 - xw[x + 1])), _mm_set1_epi16((short)xw[x + 1]));
+        p0 = _mm_mullo_epi16(p0, w0);
+        p1 = _mm_mullo_epi16(p1, w1);
+        p0 = _mm_add_epi16(p0, _mm_srli_si128(p0, 8));
+        p1 = _mm_add_epi16(p1, _mm_srli_si128(p1, 8));
+        __m128i sum = _mm_srli_epi16(_mm_add_epi16(_mm_unpacklo_epi64(p0, p1), round), 8);
+        _mm_storel_epi64((__m128i*)(out + x * 4), _mm_packus_epi16(sum, zero));
+    }
+#endif
+    for (; x < width; ++x)
+    {
+        const uint8_t* p = row + xi[x] * 4;
+        int w = xw[x];
+        for (int c = 0; c < 4; ++c) {
+            out[x * 4 + c] = lerp8(p[c], p[c + 4], w);
+        }
+    }
+}
+
+void nearestRow4(const uint8_t* row, const int32_t* xi, uint8_t* out, int width)
+{
+    for (int x = 0; x < width; ++x) {
+        memcpy(out + x * 4, row + xi[x] * 4, 4); // one 32-bit load/store
+    }
+}
+
+void nearestRow3(const uint8_t* row, const int32_t* xi, uint8_t* out, int width)
+{
+    for (int x = 0; x < width; ++x) {
+        const uint8_t* p = row + xi[x] * 3;
+        out[x * 4 + 0] = p[0];
+        out[x * 4 + 1] = p[1];
+        out[x * 4 + 2] = p[2];
+        out[x * 4 + 3] = 0xFF;
+    }
+}
+
+// pixel centres: dst i covers src (i + 0.5) * ratio
+void buildAxis(int srcLen, int dstLen, ScaleFilter filter, std::vector<int32_t>& index, std::vector<uint16_t>& weight)
+{
+    index.resize(dstLen);
+    weight.assign(dstLen, 0);
+    double ratio = (double)srcLen / dstLen;
+
+    for (int i = 0; i < dstLen; ++i)
+    {
+        if (filter == ScaleFilter::Nearest) {
+            index[i] = std::min(srcLen - 1, (int)((i + 0.5) * ratio));
+            continue;
+        }
+
+        double f = std::max(0.0, (i + 0.5) * ratio - 0.5);
+        int k = (int)f;
+        int w = (int)std::lround((f - k) * 256.0);
+        if (k >= srcLen - 1) { k = srcLen - 1; w = 0; } // last column: pair with its duplicate
+        if (w == 256) { k++; w = 0; }
+        index[i] = k;
+        weight[i] = (uint16_t)w;
+    }
+}
+
+} // namespace
+
+ImageScaler::ImageScaler(int threads)
+    : pool(threads)
+{
+}
+
+ScaleRect ImageScaler::TargetBox(int outW, int outH) const
+{
+    ScaleRect box{0, 0, outW, outH};
+    if (targetW > 0 && targetH > 0)
+    {
+        box.w = std::min(targetW, outW);
+        box.h = std::min(targetH, outH);
+        box.x = (outW - box.w) / 2;
+        box.y = (outH - box.h) / 2;
+    }
+    return box;
+}
+
+void ImageScaler::prepare(const ScaleRect& srcRect, const ScaleRect& dstRect, int srcBpp)
+{
+    if (tables.src == srcRect && tables.dst == dstRect && tables.filter == filter && tables.srcBpp == srcBpp) {
+        return; // same geometry as last frame
+    }
+
+    tables.src = srcRect;
+    tables.dst = dstRect;
+    tables.filter = filter;
+    tables.srcBpp = srcBpp;
+    buildAxis(srcRect.w, dstRect.w, filter, tables.xIndex, tables.xWeight);
+    buildAxis(srcRect.h, dstRect.h, filter, tables.yIndex, tables.yWeight);
+    stats.tableBuilds++;
+}
+
+void ImageScaler::scaleRow(int y, const uint8_t* src, int srcPitch, uint8_t* out, std::vector<uint8_t>& tmp) const
+{
+    const Tables& t = tables;
+    int bpp = t.srcBpp;
+    auto rowAt = [&](int sy) { return src + (long)(t.src.y + sy) * srcPitch + t.src.x * bpp; };
+
+    if (t.filter == ScaleFilter::Nearest)
+    {
+        const uint8_t* row = rowAt(t.yIndex[y]);
+        if (bpp == 4) nearestRow4(row, t.xIndex.data(), out, t.dst.w);
+        else          nearestRow3(row, t.xIndex.data(), out, t.dst.w);
+        return;
+    }
+
+    int y0 = t.yIndex[y];
+    int y1 = std::min(y0 + 1, t.src.h - 1);
+    uint8_t* v = tmp.data(); // src.w + 1 pixels, the extra one duplicates the last
+
+    if (bpp == 4) lerpRow(rowAt(y0), rowAt(y1), t.yWeight[y], v, t.src.w * 4);
+    else          lerpRow3(rowAt(y0), rowAt(y1), t.yWeight[y], v, t.src.w);
+    memcpy(v + t.src.w * 4, v + (t.src.w - 1) * 4, 4);
+
+    hlerpRow(v, t.xIndex.data(), t.xWeight.data(), out, t.dst.w);
+}
+
+bool ImageScaler::ScaleInto(const uint8_t* src, int srcPitch, SrcPixelFormat srcFormat, const ScaleRect& srcRect,
+                            uint8_t* dst, int dstPitch, DstPixelFormat dstFormat, const ScaleRect& dstRect,
+                            bool swapRB)
+{
+    int srcBpp = SrcBytesPerPixel(srcFormat);
+    int dstBpp = DstBytesPerPixel(dstFormat);
+    if ((srcBpp != 3 && srcBpp != 4) || dstBpp == 0 || srcRect.w <= 0 || srcRect.h <= 0 || dstRect.w <= 0 || dstRect.h <= 0) {
+        return false;
+    }
+
+    stats.frames++;
+    int bands = pool.Threads();
+    uint8_t* dstOrigin = dst + (long)dstRect.y * dstPitch + dstRect.x * dstBpp;
+
+    if (srcRect.w == dstRect.w && srcRect.h == dstRect.h)
+    {
+        // 1:1 - straight conversion in row chunks over the pool
+        ConvertRowFn convert = GetRowConverter(srcFormat, dstFormat, swapRB);
+        const uint8_t* srcOrigin = src + (long)srcRect.y * srcPitch + srcRect.x * srcBpp;
+        int chunks = (dstRect.h + kChunkRows - 1) / kChunkRows;
+        pool.Run(chunks, [&](int c)
+        {
+            int y0 = c * kChunkRows, rows = std::min(kChunkRows, dstRect.h - y0);
+            ConvertRows(convert, srcOrigin + (long)y0 * srcPitch, srcPitch,
+                        dstOrigin + (long)y0 * dstPitch, dstPitch, dstRect.w, rows);
+        });
+        return true;
+    }
+
+    stats.scaled++;
+    prepare(srcRect, dstRect, srcBpp);
+
+    // scaled rows are 4-byte pixels in the source channel order
+    bool rgb = srcFormat == SrcPixelFormat::RGBA8888 || srcFormat == SrcPixelFormat::RGB888;
+    ConvertRowFn convert = GetRowConverter(rgb ? SrcPixelFormat::RGBA8888 : SrcPixelFormat::BGRA8888, dstFormat, swapRB);
+
+    size_t tmpBytes = (size_t)(srcRect.w + 1) * 4 + 16;
+    size_t rowBytes = (size_t)dstRect.w * 4 + 16;
+    scratch.resize(bands);
+    for (auto& s : scratch) {
+        if (s.size() < tmpBytes + rowBytes) s.resize(tmpBytes + rowBytes);
+    }
+
+    // one contiguous band per thread: its own scratch, source rows walked in order
+    pool.Run(bands, [&](int b)
+    {
+        std::vector<uint8_t>& tmp = scratch[b];
+        uint8_t* row = tmp.data() + tmpBytes;
+        int y0 = dstRect.h * b / bands, y1 = dstRect.h * (b + 1) / bands;
+        for (int y = y0; y < y1; ++y)
+        {
+            scaleRow(y, src, srcPitch, row, tmp);
+            convert(row, dstOrigin + (long)y * dstPitch, dstRect.w);
+        }
+    });
+    return true;
+}
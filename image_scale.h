@@ -0,0 +1,88 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "pixel_convert.h"
+#include "worker_pool.h"
+
+enum class ScaleMode { None, Fit, Fill, Stretch, Center };
+// None    - top-left, 1:1, cropped (the old behaviour)
+// Fit     - whole image, aspect kept, letterboxed
+// Fill    - box covered, aspect kept, image cropped
+// Stretch - box covered, aspect ignored
+// Center  - 1:1, centred, cropped if larger
+enum class ScaleFilter { Nearest, Bilinear };
+
+ScaleMode ScaleModeFromName(const std::string& name);     // "fit", ... unknown = Fit
+ScaleFilter ScaleFilterFromName(const std::string& name); // "nearest" / "bilinear"
+
+struct ScaleRect {
+    int x = 0, y = 0, w = 0, h = 0;
+    bool operator==(const ScaleRect& o) const { return x == o.x && y == o.y && w == o.w && h == o.h; }
+};
+
+// Which part of the source is used (srcRect) and where it lands inside box (dstRect)
+void ComputePlacement(int srcW, int srcH, const ScaleRect& box, ScaleMode mode,
+                      ScaleRect& srcRect, ScaleRect& dstRect);
+
+//-------------------------------------------------------------------
+//* Scale + convert straight into a scanout buffer, rows split over a WorkerPool
+// Coefficient tables are kept until the geometry or filter changes (same-size images reuse them).
+class ImageScaler {
+public:
+    struct Stats {
+        uint64_t frames = 0;
+        uint64_t scaled = 0;      // frames that needed resampling (others: plain convert)
+        uint64_t tableBuilds = 0; // geometry changes
+    };
+
+    // rows per pool task for plain convert/copy: a 4K XRGB chunk (~250 KB) stays in one core's L2,
+    // and small tasks keep every thread busy when one core is slowed by other work
+    static constexpr int kChunkRows = 16;
+
+    // 1 = no pool threads yet: members are built before the app blocks its signals, and a
+    // thread started now would take SIGINT/SIGTERM - SetThreads starts them later
+    explicit ImageScaler(int threads = 1);
+
+    void SetMode(ScaleMode m) { mode = m; }
+    void SetFilter(ScaleFilter f) { filter = f; }
+    void SetTarget(int width, int height) { targetW = width; targetH = height; } // <= 0: whole output
+    void SetThreads(int threads) { pool.Resize(threads); }
+    ScaleMode Mode() const { return mode; }
+    ScaleFilter Filter() const { return filter; }
+    WorkerPool& Pool() { return pool; }
+
+    ScaleRect TargetBox(int outW, int outH) const; // configured size, centred, clipped to the output
+
+    // src: 3 or 4 bytes per pixel. Writes dstRect only - the caller clears the rest.
+    bool ScaleInto(const uint8_t* src, int srcPitch, SrcPixelFormat srcFormat, const ScaleRect& srcRect,
+                   uint8_t* dst, int dstPitch, DstPixelFormat dstFormat, const ScaleRect& dstRect,
+                   bool swapRB);
+
+    Stats GetStats() const { return stats; }
+
+private:
+    struct Tables {
+        ScaleRect src, dst;
+        ScaleFilter filter = ScaleFilter::Nearest;
+        int srcBpp = 0;
+        std::vector<int32_t> xIndex;   // source column (relative to src.x)
+        std::vector<uint16_t> xWeight; // 0..256 towards xIndex+1 (bilinear)
+        std::vector<int32_t> yIndex;
+        std::vector<uint16_t> yWeight;
+    };
+
+    void prepare(const ScaleRect& srcRect, const ScaleRect& dstRect, int srcBpp);
+    void scaleRow(int y, const uint8_t* src, int srcPitch, uint8_t* out, std::vector<uint8_t>& scratch) const;
+
+    ScaleMode mode{ScaleMode::Fit};
+    ScaleFilter filter{ScaleFilter::Bilinear};
+    int targetW{0}, targetH{0};
+
+    Tables tables;
+    std::vector<std::vector<uint8_t>> scratch; // per band: vertical blend + scaled row
+    WorkerPool pool;
+    Stats stats;
+};
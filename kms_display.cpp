@@ -0,0 +1,466 @@
+#include "logger.h"
+extern Logger gLogger; // declare external logger instance
+
+#include "kms_display.h"
+
+#if defined(HAVE_LIBDRM)
+
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <xf86drm.h>
+#include <xf86drmMode.h>
+#include <drm_fourcc.h>
+
+static uint64_t monotonicNs()
+{
+    return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+KmsDisplay::~KmsDisplay()
+{
+    Close();
+}
+
+bool KmsDisplay::Open(const std::string& device)
+{
+    Close();
+    this->device = device;
+
+    fd = open(device.c_str(), O_RDWR | O_CLOEXEC);
+    if (fd < 0) {
+        gLogger.log("KMS: cannot open ", device);
+        return false;
+    }
+
+    uint64_t dumb = 0;
+    if (drmGetCap(fd, DRM_CAP_DUMB_BUFFER, &dumb) != 0 || !dumb) {
+        gLogger.log("KMS: ", device, " has no dumb buffer support");
+        Close();
+        return false;
+    }
+
+    if (drmSetClientCap(fd, DRM_CLIENT_CAP_UNIVERSAL_PLANES, 1) != 0 ||
+        drmSetClientCap(fd, DRM_CLIENT_CAP_ATOMIC, 1) != 0)
+    {
+        gLogger.log("KMS: ", device, " does not support atomic modesetting");
+        Close();
+        return false;
+    }
+
+    if (!pickOutput() || !findPrimaryPlane() || !lookupProperties() || !createBuffers()) {
+        Close();
+        return false;
+    }
+
+    // first commit sets the mode, later ones only swap FB_ID
+    if (!commit(0, DRM_MODE_ATOMIC_ALLOW_MODESET)) {
+        gLogger.log("KMS: modeset commit failed on ", device, ": ", strerror(errno));
+        Close();
+        return false;
+    }
+    front = 0;
+    modeSet = true;
+
+    gLogger.log("KMS: ", device, " connector ", connectorId, " crtc ", crtcId, " plane ", planeId,
+                ", ", modeWidth, "x", modeHeight, ", ", kBuffers, " dumb buffers");
+    return true;
+}
+
+void KmsDisplay::Close()
+{
+    if (fd < 0) {
+        return;
+    }
+
+    if (pending >= 0) {
+        waitForFlip(100);
+    }
+
+    destroyBuffers();
+
+    if (modeBlobId) {
+        drmModeDestroyPropertyBlob(fd, modeBlobId);
+        modeBlobId = 0;
+    }
+
+    close(fd);
+    fd = -1;
+    modeSet = false;
+    front = pending = -1;
+}
+
+KmsDisplay::Buffer* KmsDisplay::BackBuffer()
+{
+    if (!isOpen()) {
+        return nullptr;
+    }
+
+    for (int i = 0; i < kBuffers; ++i) {
+        if (i != front && i != pending) {
+            return &buffers[i].view;
+        }
+    }
+    return nullptr;
+}
+
+KmsDisplay::Buffer* KmsDisplay::FrontBuffer()
+{
+    return isOpen() && front >= 0 ? &buffers[front].view : nullptr;
+}
+
+void KmsDisplay::FlushFront()
+{
+    if (isOpen() && front >= 0) {
+        drmModeDirtyFB(fd, buffers[front].fbId, nullptr, 0); // ENOSYS on most: they scan out the memory as is
+    }
+}
+
+bool KmsDisplay::Present()
+{
+    Buffer* back = BackBuffer();
+    if (back == nullptr) {
+        return false;
+    }
+    if (stages) stages->Mark(PipelineStage::Converted);
+    int next = 0;
+    for (int i = 0; i < kBuffers; ++i) {
+        if (&buffers[i].view == back) next = i;
+    }
+
+    // one flip in flight at a time - the kernel rejects a second with EBUSY
+    if (pending >= 0 && !waitForFlip(1000)) {
+        LOGW("KMS: page flip timed out on ", device);
+        pending = -1;
+    }
+
+    commitNs = monotonicNs();
+    if (!commit(next, DRM_MODE_PAGE_FLIP_EVENT | DRM_MODE_ATOMIC_NONBLOCK)) {
+        LOGW("KMS: page flip commit failed on ", device, ": ", strerror(errno));
+        return false;
+    }
+    pending = next;
+
+    // vsync-locked: return once the new buffer is on screen
+    if (!waitForFlip(1000)) {
+        return false;
+    }
+    if (stages) stages->Mark(PipelineStage::Presented);
+    return true;
+}
+
+bool KmsDisplay::pickOutput()
+{
+    drmModeRes* res = drmModeGetResources(fd);
+    if (res == nullptr) {
+        gLogger.log("KMS: drmModeGetResources failed on ", device);
+        return false;
+    }
+
+    drmModeConnector* conn = nullptr;
+    for (int i = 0; i < res->count_connectors && conn == nullptr; ++i)
+    {
+        drmModeConnector* c = drmModeGetConnector(fd, res->connectors[i]);
+        if (c && c->connection == DRM_MODE_CONNECTED && c->count_modes > 0) {
+            conn = c;
+        } else if (c) {
+            drmModeFreeConnector(c);
+        }
+    }
+
+    if (conn == nullptr) {
+        gLogger.log("KMS: no connected display on ", device);
+        drmModeFreeResources(res);
+        return false;
+    }
+
+    // preferred mode, else the first (drivers list the best first)
+    drmModeModeInfo mode = conn->modes[0];
+    for (int i = 0; i < conn->count_modes; ++i) {
+        if (conn->modes[i].type & DRM_MODE_TYPE_PREFERRED) {
+            mode = conn->modes[i];
+            break;
+        }
+    }
+
+    // CRTC: the one already driving this connector, else any the encoders can reach
+    crtcId = 0;
+    if (conn->encoder_id) {
+        if (drmModeEncoder* enc = drmModeGetEncoder(fd, conn->encoder_id)) {
+            crtcId = enc->crtc_id;
+            drmModeFreeEncoder(enc);
+        }
+    }
+    for (int e = 0; e < conn->count_encoders && crtcId == 0; ++e)
+    {
+        drmModeEncoder* enc = drmModeGetEncoder(fd, conn->encoders[e]);
+        if (enc == nullptr) continue;
+        for (int c = 0; c < res->count_crtcs; ++c) {
+            if (enc->possible_crtcs & (1u << c)) {
+                crtcId = res->crtcs[c];
+                break;
+            }
+        }
+        drmModeFreeEncoder(enc);
+    }
+
+    crtcIndex = -1;
+    for (int c = 0; c < res->count_crtcs; ++c) {
+        if (res->crtcs[c] == crtcId) crtcIndex = c;
+    }
+
+    connectorId = conn->connector_id;
+    modeWidth = mode.hdisplay;
+    modeHeight = mode.vdisplay;
+
+    drmModeFreeConnector(conn);
+    drmModeFreeResources(res);
+
+    if (crtcIndex < 0) {
+        gLogger.log("KMS: no usable CRTC for connector ", connectorId);
+        return false;
+    }
+
+    if (drmModeCreatePropertyBlob(fd, &mode, sizeof(mode), &modeBlobId) != 0) {
+        gLogger.log("KMS: cannot create mode blob on ", device);
+        return false;
+    }
+    return true;
+}
+
+bool KmsDisplay::findPrimaryPlane()
+{
+    drmModePlaneRes* planes = drmModeGetPlaneResources(fd);
+    if (planes == nullptr) {
+        return false;
+    }
+
+    planeId = 0;
+    for (uint32_t i = 0; i < planes->count_planes && planeId == 0; ++i)
+    {
+        drmModePlane* plane = drmModeGetPlane(fd, planes->planes[i]);
+        if (plane == nullptr) continue;
+
+        if (plane->possible_crtcs & (1u << crtcIndex))
+        {
+            drmModeObjectProperties* p = drmModeObjectGetProperties(fd, plane->plane_id, DRM_MODE_OBJECT_PLANE);
+            for (uint32_t k = 0; p && k < p->count_props; ++k)
+            {
+                drmModePropertyRes* prop = drmModeGetProperty(fd, p->props[k]);
+                if (prop && strcmp(prop->name, "type") == 0 && p->prop_values[k] == DRM_PLANE_TYPE_PRIMARY) {
+                    planeId = plane->plane_id;
+                }
+                drmModeFreeProperty(prop);
+            }
+            drmModeFreeObjectProperties(p);
+        }
+        drmModeFreePlane(plane);
+    }
+    drmModeFreePlaneResources(planes);
+
+    if (planeId == 0) {
+        gLogger.log("KMS: no primary plane for crtc ", crtcId);
+        return false;
+    }
+    return true;
+}
+
+uint32_t KmsDisplay::propertyId(uint32_t objectId, uint32_t objectType, const char* name)
+{
+    uint32_t id = 0;
+    drmModeObjectProperties* p = drmModeObjectGetProperties(fd, objectId, objectType);
+    for (uint32_t k = 0; p && k < p->count_props && id == 0; ++k)
+    {
+        drmModePropertyRes* prop = drmModeGetProperty(fd, p->props[k]);
+        if (prop && strcmp(prop->name, name) == 0) {
+            id = prop->prop_id;
+        }
+        drmModeFreeProperty(prop);
+    }
+    drmModeFreeObjectProperties(p);
+
+    if (id == 0) {
+        gLogger.log("KMS: object ", objectId, " has no property ", name);
+    }
+    return id;
+}
+
+bool KmsDisplay::lookupProperties()
+{
+    props.connCrtcId = propertyId(connectorId, DRM_MODE_OBJECT_CONNECTOR, "CRTC_ID");
+    props.crtcModeId = propertyId(crtcId, DRM_MODE_OBJECT_CRTC, "MODE_ID");
+    props.crtcActive = propertyId(crtcId, DRM_MODE_OBJECT_CRTC, "ACTIVE");
+    props.planeFbId = propertyId(planeId, DRM_MODE_OBJECT_PLANE, "FB_ID");
+    props.planeCrtcId = propertyId(planeId, DRM_MODE_OBJECT_PLANE, "CRTC_ID");
+    props.srcX = propertyId(planeId, DRM_MODE_OBJECT_PLANE, "SRC_X");
+    props.srcY = propertyId(planeId, DRM_MODE_OBJECT_PLANE, "SRC_Y");
+    props.srcW = propertyId(planeId, DRM_MODE_OBJECT_PLANE, "SRC_W");
+    props.srcH = propertyId(planeId, DRM_MODE_OBJECT_PLANE, "SRC_H");
+    props.crtcX = propertyId(planeId, DRM_MODE_OBJECT_PLANE, "CRTC_X");
+    props.crtcY = propertyId(planeId, DRM_MODE_OBJECT_PLANE, "CRTC_Y");
+    props.crtcW = propertyId(planeId, DRM_MODE_OBJECT_PLANE, "CRTC_W");
+    props.crtcH = propertyId(planeId, DRM_MODE_OBJECT_PLANE, "CRTC_H");
+
+    const uint32_t all[] = { props.connCrtcId, props.crtcModeId, props.crtcActive, props.planeFbId,
+                             props.planeCrtcId, props.srcX, props.srcY, props.srcW, props.srcH,
+                             props.crtcX, props.crtcY, props.crtcW, props.crtcH };
+    for (uint32_t id : all) {
+        if (id == 0) return false;
+    }
+    return true;
+}
+
+bool KmsDisplay::createBuffers()
+{
+    for (auto& b : buffers)
+    {
+        drm_mode_create_dumb create{};
+        create.width = modeWidth;
+        create.height = modeHeight;
+        create.bpp = 32;
+        if (drmIoctl(fd, DRM_IOCTL_MODE_CREATE_DUMB, &create) != 0) {
+            gLogger.log("KMS: cannot create ", modeWidth, "x", modeHeight, " dumb buffer: ", strerror(errno));
+            return false;
+        }
+        b.handle = create.handle;
+        b.size = create.size;
+
+        uint32_t handles[4] = { create.handle };
+        uint32_t pitches[4] = { create.pitch };
+        uint32_t offsets[4] = { 0 };
+        if (drmModeAddFB2(fd, modeWidth, modeHeight, DRM_FORMAT_XRGB8888, handles, pitches, offsets, &b.fbId, 0) != 0) {
+            gLogger.log("KMS: drmModeAddFB2 failed: ", strerror(errno));
+            return false;
+        }
+
+        drm_mode_map_dumb map{};
+        map.handle = create.handle;
+        if (drmIoctl(fd, DRM_IOCTL_MODE_MAP_DUMB, &map) != 0) {
+            gLogger.log("KMS: cannot map dumb buffer: ", strerror(errno));
+            return false;
+        }
+
+        void* p = mmap(nullptr, create.size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, map.offset);
+        if (p == MAP_FAILED) {
+            gLogger.log("KMS: mmap of dumb buffer failed: ", strerror(errno));
+            return false;
+        }
+        memset(p, 0, create.size); // start black
+
+        b.view.pixels = (uint8_t*)p;
+        b.view.pitch = create.pitch;
+        b.view.width = modeWidth;
+        b.view.height = modeHeight;
+        b.view.format = DstPixelFormat::XRGB8888;
+    }
+    return true;
+}
+
+void KmsDisplay::destroyBuffers()
+{
+    for (auto& b : buffers)
+    {
+        if (b.view.pixels) {
+            munmap(b.view.pixels, b.size);
+        }
+        if (b.fbId) {
+            drmModeRmFB(fd, b.fbId);
+        }
+        if (b.handle) {
+            drm_mode_destroy_dumb destroy{};
+            destroy.handle = b.handle;
+            drmIoctl(fd, DRM_IOCTL_MODE_DESTROY_DUMB, &destroy);
+        }
+        b = DumbBuffer{};
+    }
+}
+
+bool KmsDisplay::commit(int buffer, uint32_t flags)
+{
+    drmModeAtomicReq* req = drmModeAtomicAlloc();
+    if (req == nullptr) {
+        return false;
+    }
+
+    if (flags & DRM_MODE_ATOMIC_ALLOW_MODESET)
+    {
+        drmModeAtomicAddProperty(req, connectorId, props.connCrtcId, crtcId);
+        drmModeAtomicAddProperty(req, crtcId, props.crtcModeId, modeBlobId);
+        drmModeAtomicAddProperty(req, crtcId, props.crtcActive, 1);
+    }
+
+    // full-screen plane; SRC_* are 16.16 fixed point
+    drmModeAtomicAddProperty(req, planeId, props.planeFbId, buffers[buffer].fbId);
+    drmModeAtomicAddProperty(req, planeId, props.planeCrtcId, crtcId);
+    drmModeAtomicAddProperty(req, planeId, props.srcX, 0);
+    drmModeAtomicAddProperty(req, planeId, props.srcY, 0);
+    drmModeAtomicAddProperty(req, planeId, props.srcW, (uint64_t)modeWidth << 16);
+    drmModeAtomicAddProperty(req, planeId, props.srcH, (uint64_t)modeHeight << 16);
+    drmModeAtomicAddProperty(req, planeId, props.crtcX, 0);
+    drmModeAtomicAddProperty(req, planeId, props.crtcY, 0);
+    drmModeAtomicAddProperty(req, planeId, props.crtcW, modeWidth);
+    drmModeAtomicAddProperty(req, planeId, props.crtcH, modeHeight);
+
+    int ret = drmModeAtomicCommit(fd, req, flags, this);
+    drmModeAtomicFree(req);
+    return ret == 0;
+}
+
+bool KmsDisplay::waitForFlip(int timeoutMs)
+{
+    drmEventContext ctx{};
+    ctx.version = 2;
+    ctx.page_flip_handler = &KmsDisplay::onPageFlip;
+
+    while (pending >= 0)
+    {
+        pollfd pfd{ fd, POLLIN, 0 };
+        int ret = poll(&pfd, 1, timeoutMs);
+        if (ret <= 0) {
+            return false;
+        }
+        drmHandleEvent(fd, &ctx);
+    }
+    return true;
+}
+
+//static
+void KmsDisplay::onPageFlip(int, unsigned, unsigned, unsigned, void* data)
+{
+    auto* self = static_cast<KmsDisplay*>(data);
+
+    self->front = self->pending;
+    self->pending = -1;
+
+    uint64_t us = (monotonicNs() - self->commitNs) / 1000;
+    self->flipStats.flips++;
+    self->flipStats.lastUs = us;
+    self->flipStats.totalUs += us;
+    if (us > self->flipStats.maxUs) self->flipStats.maxUs = us;
+}
+
+#else // !HAVE_LIBDRM
+
+KmsDisplay::~KmsDisplay() {}
+
+bool KmsDisplay::Open(const std::string& device)
+{
+    this->device = device;
+    gLogger.log("KMS: built without libdrm, DrawMode 3 unavailable");
+    return false;
+}
+
+void KmsDisplay::Close() {}
+KmsDisplay::Buffer* KmsDisplay::BackBuffer() { return nullptr; }
+KmsDisplay::Buffer* KmsDisplay::FrontBuffer() { return nullptr; }
+void KmsDisplay::FlushFront() {}
+bool KmsDisplay::Present() { return false; }
+
+#endif
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+#include "framebuffer.h"
+#include "pixel_convert.h"
+#include "stage_metrics.h"
+
+//-------------------------------------------------------------------
+//* KMS/DRM atomic output (DrawMode 3) - dumb buffers mapped once, page flipped on vsync
+// Built only with libdrm (HAVE_LIBDRM), otherwise Open() fails and DrawMode 3 draws nothing.
+class KmsDisplay {
+public:
+    struct Buffer {
+        uint8_t* pixels = nullptr;
+        uint32_t pitch = 0;
+        uint32_t width = 0;
+        uint32_t height = 0;
+        DstPixelFormat format = DstPixelFormat::XRGB8888;
+    };
+
+    using FlipStats = Framebuffer::FlipStats; // here: commit -> flip event
+
+    KmsDisplay() = default;
+    ~KmsDisplay();
+
+    KmsDisplay(const KmsDisplay&) = delete;
+    KmsDisplay& operator=(const KmsDisplay&) = delete;
+
+    bool Open(const std::string& device = "/dev/dri/card0");
+    void Close();
+    bool isOpen() const { return fd >= 0 && modeSet; }
+
+    Buffer* BackBuffer(); // neither on screen nor queued
+    Buffer* FrontBuffer(); // on screen now, nullptr when closed
+    void FlushFront();     // drawn into FrontBuffer(): tell drivers that don't scan out live memory
+    bool Present();       // atomic commit of the back buffer, flips on the next vsync
+    FlipStats GetFlipStats() const { return flipStats; }
+    void SetStageClock(StageClock* clock) { stages = clock; } // Present() marks converted/presented
+
+private:
+    static constexpr int kBuffers = 3; // on screen, flip pending, being drawn
+
+    struct DumbBuffer {
+        Buffer view;
+        uint32_t handle = 0;
+        uint32_t fbId = 0;
+        uint64_t size = 0;
+    };
+
+    struct PropIds {
+        uint32_t connCrtcId = 0;
+        uint32_t crtcModeId = 0, crtcActive = 0;
+        uint32_t planeFbId = 0, planeCrtcId = 0;
+        uint32_t srcX = 0, srcY = 0, srcW = 0, srcH = 0;
+        uint32_t crtcX = 0, crtcY = 0, crtcW = 0, crtcH = 0;
+    };
+
+    bool pickOutput();
+    bool findPrimaryPlane();
+    bool lookupProperties();
+    bool createBuffers();
+    void destroyBuffers();
+    bool commit(int buffer, uint32_t flags);
+    bool waitForFlip(int timeoutMs);
+    uint32_t propertyId(uint32_t objectId, uint32_t objectType, const char* name);
+
+    static void onPageFlip(int fd, unsigned frame, unsigned sec, unsigned usec, void* data);
+
+    std::string device;
+    int fd{-1};
+    bool modeSet{false};
+
+    uint32_t connectorId{0}, crtcId{0}, planeId{0}, modeBlobId{0};
+    int crtcIndex{-1};
+    uint32_t modeWidth{0}, modeHeight{0};
+    PropIds props;
+
+    DumbBuffer buffers[kBuffers];
+    int front{-1};   // scanned out
+    int pending{-1}; // committed, flip not completed yet
+    StageClock* stages{nullptr};
+
+    uint64_t commitNs{0};
+    FlipStats flipStats;
+};
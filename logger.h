@@ -1,50 +1,384 @@
-
 #pragma once
 
+#include <pthread.h>
+#include <signal.h>
+#include <syslog.h>
+
+#include <algorithm>
+#include <atomic>
+#include <charconv>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
 #include <fstream>
 #include <iostream>
+#include <memory>
 #include <mutex>
-#include <syslog.h>
 #include <sstream>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <type_traits>
+
+
+//-------------------------------------------------------------------
+//* Levels for the LOGE/W/I/D and PRINTW/I/D macros at the end. A call above LOG_MAX_LEVEL
+// (build flag, -DLOG_MAX_LEVEL=1 keeps errors and warnings) is not compiled in; the others check
+// the runtime level (--loglevel) before any argument is evaluated. Plain log()/println() always log.
+enum class LogLevel : int { Error, Warn, Info, Debug };
 
+#ifndef LOG_MAX_LEVEL
+#define LOG_MAX_LEVEL 3 // LogLevel::Debug - everything compiled in
+#endif
 
+//-------------------------------------------------------------------
+//* Asynchronous logger: log() formats the line on the calling thread into a fixed buffer and
+// hands it to a bounded lock-free ring (multi-producer, one consumer); a background thread
+// writes whatever is queued in one go to the file (or stdout) and syslog.
+// log() (and LOGE/LOGW) never loses a line: on a full ring it waits for the writer.
+// logOrDrop() (LOGI/LOGD, the per-image lines) drops and counts instead, and the writer puts
+// the count into the log. Lines longer than kLineBytes are cut. Flush() waits for everything
+// queued so far.
 class Logger {
-private:
-    std::ofstream logFile;
-    std::mutex logMutex;
 public:
-    bool Open(const std::string& filename) 
+    static constexpr size_t kSlots = 4096;     // power of two - 2 MB, a few seconds of display lines
+    static constexpr size_t kLineBytes = 500;  // timestamp included
+    static constexpr auto kBatchDelay = std::chrono::milliseconds(1); // busy writer: collect lines, no wakeups
+
+    Logger() : slots(new Slot[kSlots])
     {
-        logFile.open(filename, std::ios::app | std::ios::out);
-        return logFile.is_open();
+        for (size_t i = 0; i < kSlots; ++i) {
+            slots[i].seq.store(i, std::memory_order_relaxed);
+        }
+
+        // the writer must never take a signal meant for the main thread's signalfd
+        sigset_t all, old;
+        sigfillset(&all);
+        pthread_sigmask(SIG_BLOCK, &all, &old);
+        writer = std::thread([this] { writeLoop(); });
+        pthread_sigmask(SIG_SETMASK, &old, nullptr);
     }
-    
-    ~Logger() {
+
+    ~Logger()
+    {
+        {
+            std::lock_guard<std::mutex> lock(wakeMutex);
+            stop = true;
+        }
+        wake.notify_one();
+        writer.join();
         if (logFile.is_open()) {
             logFile.close();
         }
     }
-    
+
+    bool Open(const std::string& filename)
+    {
+        std::lock_guard<std::mutex> lock(outMutex);
+        logFile.open(filename, std::ios::app | std::ios::out);
+        return logFile.is_open();
+    }
+
+    void SetSyslog(bool on) { toSyslog = on; } // default on
+
+    template<typename... Args>
+    void log(Args&&... args) // waits while the ring is full
+    {
+        Line line;
+        line.stamp();
+        (line.put(args), ...);
+        push(line.text, line.length, true);
+    }
+
     template<typename... Args>
-    void log(Args&&... args) 
+    void logOrDrop(Args&&... args) // never waits, counted in Dropped()
+    {
+        Line line;
+        line.stamp();
+        (line.put(args), ...);
+        push(line.text, line.length, false);
+    }
+
+    void Flush() // wait until every line queued before the call is written
+    {
+        uint64_t target = head.load(std::memory_order_acquire);
+        while (written.load(std::memory_order_acquire) < target) {
+            wakeWriter();
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+
+    uint64_t Written() const { return written.load(std::memory_order_relaxed); }
+    uint64_t Dropped() const { return dropped.load(std::memory_order_relaxed); }
+
+    static void SetLevel(LogLevel l) { level.store((int)l, std::memory_order_relaxed); }
+    static LogLevel Level() { return (LogLevel)level.load(std::memory_order_relaxed); }
+    static bool Enabled(LogLevel l) { return (int)l <= level.load(std::memory_order_relaxed); }
+
+    static const char* LevelName(LogLevel l)
+    {
+        switch (l)
+        {
+            case LogLevel::Error: return "error";
+            case LogLevel::Warn:  return "warn";
+            case LogLevel::Info:  return "info";
+            case LogLevel::Debug: return "debug";
+            default:              return "?";
+        }
+    }
+
+    static bool ParseLevel(const std::string& name, LogLevel& l) // "error".."debug" or 0..3
+    {
+        for (int i = (int)LogLevel::Error; i <= (int)LogLevel::Debug; ++i)
+        {
+            if (name == LevelName((LogLevel)i) || name == std::to_string(i)) {
+                l = (LogLevel)i;
+                return true;
+            }
+        }
+        return false;
+    }
+
+private:
+    // one line, formatted without allocating for strings and numbers
+    struct Line {
+        char text[kLineBytes];
+        size_t length = 0;
+
+        void append(std::string_view s)
+        {
+            size_t n = std::min(s.size(), kLineBytes - length);
+            memcpy(text + length, s.data(), n);
+            length += n;
+        }
+
+        // "[YYYY-mm-dd HH:MM:SS] ", localtime once per second per thread
+        void stamp()
+        {
+            static thread_local time_t cachedSecond = -1;
+            static thread_local char cached[32];
+            static thread_local size_t cachedLength = 0;
+
+            time_t now = time(nullptr);
+            if (now != cachedSecond)
+            {
+                struct tm tm;
+                localtime_r(&now, &tm);
+                cachedLength = strftime(cached, sizeof(cached), "[%Y-%m-%d %H:%M:%S] ", &tm);
+                cachedSecond = now;
+            }
+            append(std::string_view(cached, cachedLength));
+        }
+
+        template<typename T>
+        void put(const T& value)
+        {
+            using V = std::decay_t<T>;
+            if constexpr (std::is_convertible_v<const T&, std::string_view>) {
+                if constexpr (std::is_pointer_v<T>) {
+                    if (value == nullptr) return;
+                }
+                append(std::string_view(value));
+            }
+            else if constexpr (std::is_same_v<V, char>) {
+                append(std::string_view(&value, 1));
+            }
+            else if constexpr (std::is_same_v<V, bool>) {
+                append(value ? "1" : "0");
+            }
+            else if constexpr (std::is_integral_v<V> && sizeof(V) > 1) {
+                char digits[24];
+                auto result = std::to_chars(digits, digits + sizeof(digits), value);
+                append(std::string_view(digits, result.ptr - digits));
+            }
+            else if constexpr (std::is_floating_point_v<V>) {
+                char digits[32];
+                int n = snprintf(digits, sizeof(digits), "%g", (double)value); // as ostream prints it
+                append(std::string_view(digits, n > 0 ? std::min((size_t)n, sizeof(digits) - 1) : 0));
+            }
+            else { // anything else with an operator<<
+                std::ostringstream oss;
+                oss << value;
+                append(oss.str());
+            }
+        }
+    };
+
+    struct Slot {
+        std::atomic<uint64_t> seq; // == position: free for it, == position + 1: holds its line
+        uint32_t length;
+        char text[kLineBytes];
+    };
+
+    // claim a position, copy, publish; full = wait for the writer, or drop and count
+    void push(const char* text, size_t length, bool wait)
     {
-        std::lock_guard<std::mutex> lock(logMutex);
+        uint64_t pos = head.load(std::memory_order_relaxed);
+        Slot* slot;
+        for (;;)
+        {
+            slot = &slots[pos & (kSlots - 1)];
+            int64_t diff = (int64_t)slot->seq.load(std::memory_order_acquire) - (int64_t)pos;
+            if (diff == 0) {
+                if (head.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+            }
+            else if (diff < 0) {
+                if (!wait) {
+                    dropped.fetch_add(1, std::memory_order_relaxed);
+                    return;
+                }
+                waitForRoom(*slot, pos);
+                pos = head.load(std::memory_order_relaxed);
+            }
+            else {
+                pos = head.load(std::memory_order_relaxed);
+            }
+        }
 
-        auto now = std::chrono::system_clock::now();
-        auto time_t = std::chrono::system_clock::to_time_t(now);
-        auto tm = *std::localtime(&time_t);
+        memcpy(slot->text, text, length);
+        slot->length = (uint32_t)length;
+        slot->seq.store(pos + 1, std::memory_order_release);
 
-        char timestamp[64];
-        std::strftime(timestamp, sizeof(timestamp), "%Y-%m-%d %H:%M:%S", &tm);
+        std::atomic_thread_fence(std::memory_order_seq_cst); // pairs with the writer going idle
+        if (idle.load(std::memory_order_relaxed)) {
+            wakeWriter();
+        }
+    }
 
-        std::ostringstream oss;
-        oss << "[" << timestamp << "] ";
-        (oss << ... << args);
-        oss << std::endl;
+    void wakeWriter()
+    {
+        std::lock_guard<std::mutex> lock(wakeMutex);
+        wake.notify_one();
+    }
 
-        auto& out = logFile.is_open() ? logFile : std::cout;
-        out << oss.str(); 
-        out.flush();
+    // until the writer has freed the slot pos needs (the timeout covers a missed notify)
+    void waitForRoom(const Slot& slot, uint64_t pos)
+    {
+        waiting.fetch_add(1, std::memory_order_seq_cst);
+        wakeWriter();
+        {
+            std::unique_lock<std::mutex> lock(roomMutex);
+            room.wait_for(lock, std::chrono::milliseconds(1),
+                          [&] { return slot.seq.load(std::memory_order_acquire) >= pos; });
+        }
+        waiting.fetch_sub(1, std::memory_order_relaxed);
+    }
 
-        syslog(LOG_INFO, "%s", oss.str().c_str());}
+    bool pending() const
+    {
+        return slots[tail & (kSlots - 1)].seq.load(std::memory_order_acquire) == tail + 1;
+    }
+
+    void writeLoop()
+    {
+        std::string batch;
+        batch.reserve(64 * 1024);
+        uint64_t reportedDrops = 0;
+
+        for (;;)
+        {
+            // everything published so far, in order, at most one ring per write
+            batch.clear();
+            uint64_t lines = 0;
+            while (lines < kSlots && pending())
+            {
+                Slot& slot = slots[tail & (kSlots - 1)];
+                batch.append(slot.text, slot.length);
+                batch += '\n';
+                if (toSyslog) {
+                    syslog(LOG_INFO, "%.*s", (int)slot.length, slot.text);
+                }
+                slot.seq.store(tail + kSlots, std::memory_order_release);
+                tail++;
+                lines++;
+            }
+
+            uint64_t drops = dropped.load(std::memory_order_relaxed);
+            if (drops != reportedDrops)
+            {
+                Line note;
+                note.stamp();
+                note.put("Logger: ");
+                note.put(drops - reportedDrops);
+                note.put(" lines dropped, queue full");
+                batch.append(note.text, note.length);
+                batch += '\n';
+                reportedDrops = drops;
+            }
+
+            if (!batch.empty())
+            {
+                std::lock_guard<std::mutex> lock(outMutex);
+                auto& out = logFile.is_open() ? logFile : std::cout;
+                out.write(batch.data(), batch.size());
+                out.flush();
+            }
+            written.fetch_add(lines, std::memory_order_release);
+
+            if (lines > 0 && waiting.load(std::memory_order_seq_cst) > 0)
+            {
+                std::lock_guard<std::mutex> lock(roomMutex);
+                room.notify_all();
+            }
+
+            std::unique_lock<std::mutex> lock(wakeMutex);
+            if (stop && !pending()) {
+                return;
+            }
+            if (lines > 0) // busy: let the next lines pile up instead of being woken for each
+            {
+                wake.wait_for(lock, kBatchDelay,
+                              [this] { return stop || waiting.load(std::memory_order_relaxed) > 0; });
+                continue;
+            }
+            idle.store(true, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (!pending() && !stop) {
+                wake.wait_for(lock, std::chrono::milliseconds(100));
+            }
+            idle.store(false, std::memory_order_relaxed);
+        }
+    }
+
+    std::unique_ptr<Slot[]> slots;
+    alignas(64) std::atomic<uint64_t> head{0}; // next position to claim (producers)
+    alignas(64) uint64_t tail = 0;             // next position to write (writer only)
+    std::atomic<uint64_t> written{0};
+    std::atomic<uint64_t> dropped{0};
+    std::atomic<bool> idle{false};
+    std::atomic<int> waiting{0}; // producers blocked on a full ring
+    std::atomic<bool> toSyslog{true};
+
+    std::mutex wakeMutex;
+    std::condition_variable wake;
+    bool stop = false;
+
+    std::mutex roomMutex;
+    std::condition_variable room; // writer freed slots
+
+    static inline std::atomic<int> level{(int)LogLevel::Info};
+
+    std::mutex outMutex; // Open() vs. the writer
+    std::ofstream logFile;
+    std::thread writer;
 };
+
+#define LOG_AT(lvl, sink, ...)                                  \
+    do {                                                        \
+        if constexpr ((int)(lvl) <= LOG_MAX_LEVEL) {            \
+            if (Logger::Enabled(lvl)) sink(__VA_ARGS__);        \
+        }                                                       \
+    } while (0)
+
+// to gLogger (LogFile / stdout, syslog); errors and warnings wait for room, info/debug may drop
+#define LOGE(...) LOG_AT(LogLevel::Error, gLogger.log, __VA_ARGS__)
+#define LOGW(...) LOG_AT(LogLevel::Warn, gLogger.log, __VA_ARGS__)
+#define LOGI(...) LOG_AT(LogLevel::Info, gLogger.logOrDrop, __VA_ARGS__)
+#define LOGD(...) LOG_AT(LogLevel::Debug, gLogger.logOrDrop, __VA_ARGS__)
+
+// to the console through println (print.h)
+#define PRINTW(...) LOG_AT(LogLevel::Warn, println, __VA_ARGS__)
+#define PRINTI(...) LOG_AT(LogLevel::Info, println, __VA_ARGS__)
+#define PRINTD(...) LOG_AT(LogLevel::Debug, println, __VA_ARGS__)
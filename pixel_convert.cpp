@@ -0,0 +1,332 @@
+#include <cstring>
+
+#if defined(__ARM_NEON)
+#include <arm_neon.h>
+#elif defined(__SSSE3__)
+#include <tmmintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#include "pixel_convert.h"
+
+// Kernels are instantiated per (source bytes per pixel, destination format).
+// BGR-ordered sources and RGBOrder=1 are served by the R/B-swapped destination,
+// so 2 x 4 specialisations cover every supported pair.
+
+namespace {
+
+//-------------------------------------------------------------------
+//* Scalar reference - also handles the tail of every SIMD row
+template <DstPixelFormat Dst>
+inline void storePixel(uint8_t* d, uint8_t r, uint8_t g, uint8_t b)
+{
+    if constexpr (Dst == DstPixelFormat::RGB565) {
+        uint16_t p = (uint16_t)(((r & 0xF8) << 8) | ((g & 0xFC) << 3) | (b >> 3));
+        memcpy(d, &p, 2);
+    }
+    else if constexpr (Dst == DstPixelFormat::BGR565) {
+        uint16_t p = (uint16_t)(((b & 0xF8) << 8) | ((g & 0xFC) << 3) | (r >> 3));
+        memcpy(d, &p, 2);
+    }
+    else if constexpr (Dst == DstPixelFormat::XRGB8888) {
+        d[0] = b; d[1] = g; d[2] = r; d[3] = 0xFF;
+    }
+    else {
+        d[0] = r; d[1] = g; d[2] = b; d[3] = 0xFF;
+    }
+}
+
+template <DstPixelFormat Dst>
+constexpr int dstBpp()
+{
+    return (Dst == DstPixelFormat::RGB565 || Dst == DstPixelFormat::BGR565) ? 2 : 4;
+}
+
+template <int SrcBpp, DstPixelFormat Dst>
+void scalarRow(const uint8_t* src, uint8_t* dst, int width)
+{
+    for (int x = 0; x < width; ++x, src += SrcBpp, dst += dstBpp<Dst>()) {
+        storePixel<Dst>(dst, src[0], src[1], src[2]);
+    }
+}
+
+//-------------------------------------------------------------------
+//* SIMD bodies - return the number of pixels done, scalar finishes the row
+#if defined(__ARM_NEON)
+
+template <int SrcBpp, DstPixelFormat Dst>
+int simdRow(const uint8_t* src, uint8_t* dst, int width)
+{
+    int x = 0;
+    for (; x + 16 <= width; x += 16, src += 16 * SrcBpp, dst += 16 * dstBpp<Dst>())
+    {
+        uint8x16_t r, g, b;
+        if constexpr (SrcBpp == 4) {
+            uint8x16x4_t px = vld4q_u8(src);
+            r = px.val[0]; g = px.val[1]; b = px.val[2];
+        } else {
+            uint8x16x3_t px = vld3q_u8(src);
+            r = px.val[0]; g = px.val[1]; b = px.val[2];
+        }
+
+        if constexpr (dstBpp<Dst>() == 2)
+        {
+            // top channel in the high byte, then shift-right-insert the other two
+            constexpr bool rgb = Dst == DstPixelFormat::RGB565;
+            uint8x16_t hi = rgb ? r : b;
+            uint8x16_t lo = rgb ? b : r;
+
+            uint16x8_t p0 = vshll_n_u8(vget_low_u8(hi), 8);
+            p0 = vsriq_n_u16(p0, vshll_n_u8(vget_low_u8(g), 8), 5);
+            p0 = vsriq_n_u16(p0, vshll_n_u8(vget_low_u8(lo), 8), 11);
+
+            uint16x8_t p1 = vshll_n_u8(vget_high_u8(hi), 8);
+            p1 = vsriq_n_u16(p1, vshll_n_u8(vget_high_u8(g), 8), 5);
+            p1 = vsriq_n_u16(p1, vshll_n_u8(vget_high_u8(lo), 8), 11);
+
+            vst1q_u16((uint16_t*)dst, p0);
+            vst1q_u16((uint16_t*)dst + 8, p1);
+        }
+        else
+        {
+            uint8x16x4_t out;
+            if constexpr (Dst == DstPixelFormat::XRGB8888) {
+                out.val[0] = b; out.val[1] = g; out.val[2] = r;
+            } else {
+                out.val[0] = r; out.val[1] = g; out.val[2] = b;
+            }
+            out.val[3] = vdupq_n_u8(0xFF);
+            vst4q_u8(dst, out);
+        }
+    }
+    return x;
+}
+
+#elif defined(__SSE2__)
+
+// 4 pixels as 0xAABBGGRR lanes; 3-byte sources need pshufb
+template <int SrcBpp>
+inline __m128i load4(const uint8_t* src)
+{
+    if constexpr (SrcBpp == 4) {
+        return _mm_loadu_si128((const __m128i*)src);
+    }
+#if defined(__SSSE3__)
+    else {
+        const __m128i expand = _mm_setr_epi8(0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1);
+        return _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)src), expand);
+    }
+#else
+    else {
+        return _mm_setzero_si128(); // not reached, see simdRow
+    }
+#endif
+}
+
+// 0xAABBGGRR lanes -> 565 in the low 16 bits, sign-extended for packs_epi32
+template <DstPixelFormat Dst>
+inline __m128i to565(__m128i v)
+{
+    const __m128i m5lo = _mm_set1_epi32(0xF8);
+    const __m128i m6 = _mm_set1_epi32(0xFC00);
+    const __m128i m5hi = _mm_set1_epi32(0xF80000);
+
+    __m128i g = _mm_srli_epi32(_mm_and_si128(v, m6), 5);
+    __m128i p;
+    if constexpr (Dst == DstPixelFormat::RGB565) {
+        p = _mm_or_si128(_mm_slli_epi32(_mm_and_si128(v, m5lo), 8),
+                         _mm_srli_epi32(_mm_and_si128(v, m5hi), 19));
+    } else {
+        p = _mm_or_si128(_mm_srli_epi32(_mm_and_si128(v, m5hi), 8),
+                         _mm_srli_epi32(_mm_and_si128(v, m5lo), 3));
+    }
+    p = _mm_or_si128(p, g);
+    return _mm_srai_epi32(_mm_slli_epi32(p, 16), 16);
+}
+
+template <DstPixelFormat Dst>
+inline __m128i to8888(__m128i v)
+{
+    const __m128i alpha = _mm_set1_epi32((int)0xFF000000);
+    if constexpr (Dst == DstPixelFormat::XRGB8888) {
+#if defined(__SSSE3__)
+        const __m128i swap = _mm_setr_epi8(2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15);
+        v = _mm_shuffle_epi8(v, swap);
+#else
+        const __m128i mr = _mm_set1_epi32(0xFF);
+        const __m128i mg = _mm_set1_epi32(0xFF00);
+        v = _mm_or_si128(_mm_or_si128(_mm_slli_epi32(_mm_and_si128(v, mr), 16),
+                                      _mm_and_si128(_mm_srli_epi32(v, 16), mr)),
+                         _mm_and_si128(v, mg));
+#endif
+    }
+    return _mm_or_si128(v, alpha);
+}
+
+template <int SrcBpp, DstPixelFormat Dst>
+int simdRow(const uint8_t* src, uint8_t* dst, int width)
+{
+#if !defined(__SSSE3__)
+    if constexpr (SrcBpp == 3) {
+        return 0; // no byte shuffle on plain SSE2 - scalar path
+    }
+#endif
+    // 3-byte loads read 16 bytes for 12 used: keep one spare pixel in the row
+    const int guard = SrcBpp == 3 ? 2 : 0;
+
+    int x = 0;
+    for (; x + 8 + guard <= width; x += 8, src += 8 * SrcBpp, dst += 8 * dstBpp<Dst>())
+    {
+        __m128i v0 = load4<SrcBpp>(src);
+        __m128i v1 = load4<SrcBpp>(src + 4 * SrcBpp);
+
+        if constexpr (dstBpp<Dst>() == 2) {
+            _mm_storeu_si128((__m128i*)dst, _mm_packs_epi32(to565<Dst>(v0), to565<Dst>(v1)));
+        } else {
+            _mm_storeu_si128((__m128i*)dst, to8888<Dst>(v0));
+            _mm_storeu_si128((__m128i*)dst + 1, to8888<Dst>(v1));
+        }
+    }
+    return x;
+}
+
+#else
+
+template <int SrcBpp, DstPixelFormat Dst>
+int simdRow(const uint8_t*, uint8_t*, int)
+{
+    return 0;
+}
+
+#endif
+
+template <int SrcBpp, DstPixelFormat Dst>
+void convertRow(const uint8_t* src, uint8_t* dst, int width)
+{
+    int done = simdRow<SrcBpp, Dst>(src, dst, width);
+    scalarRow<SrcBpp, Dst>(src + done * SrcBpp, dst + done * dstBpp<Dst>(), width - done);
+}
+
+// [src 4/3 bytes][dst format - 1]
+const ConvertRowFn kKernels[2][4] = {
+    { convertRow<4, DstPixelFormat::RGB565>, convertRow<4, DstPixelFormat::BGR565>,
+      convertRow<4, DstPixelFormat::XRGB8888>, convertRow<4, DstPixelFormat::XBGR8888> },
+    { convertRow<3, DstPixelFormat::RGB565>, convertRow<3, DstPixelFormat::BGR565>,
+      convertRow<3, DstPixelFormat::XRGB8888>, convertRow<3, DstPixelFormat::XBGR8888> },
+};
+
+DstPixelFormat swappedRB(DstPixelFormat f)
+{
+    switch (f) {
+        case DstPixelFormat::RGB565:   return DstPixelFormat::BGR565;
+        case DstPixelFormat::BGR565:   return DstPixelFormat::RGB565;
+        case DstPixelFormat::XRGB8888: return DstPixelFormat::XBGR8888;
+        case DstPixelFormat::XBGR8888: return DstPixelFormat::XRGB8888;
+        default:                       return f;
+    }
+}
+
+} // namespace
+
+
+DstPixelFormat DstFormatFromVInfo(const fb_var_screeninfo& vinfo)
+{
+    const auto& r = vinfo.red;
+    const auto& g = vinfo.green;
+    const auto& b = vinfo.blue;
+
+    if (vinfo.bits_per_pixel == 16 && r.length == 5 && g.length == 6 && b.length == 5 && g.offset == 5)
+    {
+        if (r.offset == 11 && b.offset == 0) return DstPixelFormat::RGB565;
+        if (r.offset == 0 && b.offset == 11) return DstPixelFormat::BGR565;
+    }
+    else if (vinfo.bits_per_pixel == 32 && r.length == 8 && g.length == 8 && b.length == 8 && g.offset == 8)
+    {
+        if (r.offset == 16 && b.offset == 0) return DstPixelFormat::XRGB8888;
+        if (r.offset == 0 && b.offset == 16) return DstPixelFormat::XBGR8888;
+    }
+    return DstPixelFormat::Unknown;
+}
+
+int SrcBytesPerPixel(SrcPixelFormat format)
+{
+    switch (format) {
+        case SrcPixelFormat::RGBA8888:
+        case SrcPixelFormat::BGRA8888: return 4;
+        case SrcPixelFormat::RGB888:
+        case SrcPixelFormat::BGR888:   return 3;
+        default:                       return 0;
+    }
+}
+
+int DstBytesPerPixel(DstPixelFormat format)
+{
+    switch (format) {
+        case DstPixelFormat::RGB565:
+        case DstPixelFormat::BGR565:   return 2;
+        case DstPixelFormat::XRGB8888:
+        case DstPixelFormat::XBGR8888: return 4;
+        default:                       return 0;
+    }
+}
+
+const char* PixelFormatName(SrcPixelFormat format)
+{
+    switch (format) {
+        case SrcPixelFormat::RGBA8888: return "RGBA8888";
+        case SrcPixelFormat::BGRA8888: return "BGRA8888";
+        case SrcPixelFormat::RGB888:   return "RGB888";
+        case SrcPixelFormat::BGR888:   return "BGR888";
+        default:                       return "unknown";
+    }
+}
+
+const char* PixelFormatName(DstPixelFormat format)
+{
+    switch (format) {
+        case DstPixelFormat::RGB565:   return "RGB565";
+        case DstPixelFormat::BGR565:   return "BGR565";
+        case DstPixelFormat::XRGB8888: return "XRGB8888";
+        case DstPixelFormat::XBGR8888: return "XBGR8888";
+        default:                       return "unknown";
+    }
+}
+
+ConvertRowFn GetRowConverter(SrcPixelFormat src, DstPixelFormat dst, bool swapRB)
+{
+    if (src == SrcPixelFormat::Unknown || dst == DstPixelFormat::Unknown) {
+        return nullptr;
+    }
+
+    bool bgrSource = src == SrcPixelFormat::BGRA8888 || src == SrcPixelFormat::BGR888;
+    if (bgrSource != swapRB) {
+        dst = swappedRB(dst);
+    }
+
+    int row = SrcBytesPerPixel(src) == 4 ? 0 : 1;
+    return kKernels[row][(int)dst - 1];
+}
+
+void ConvertRows(ConvertRowFn convert,
+                 const uint8_t* src, int srcPitch,
+                 uint8_t* dst, int dstPitch,
+                 int width, int rows)
+{
+    for (int y = 0; y < rows; ++y) {
+        convert(src + (long)y * srcPitch, dst + (long)y * dstPitch, width);
+    }
+}
+
+const char* PixelKernelIsa()
+{
+#if defined(__ARM_NEON)
+    return "neon";
+#elif defined(__SSSE3__)
+    return "ssse3";
+#elif defined(__SSE2__)
+    return "sse2";
+#else
+    return "scalar";
+#endif
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <linux/fb.h>
+
+#include <cstdint>
+
+// Decoded source rows - named in memory byte order (R,G,B,A / R,G,B)
+enum class SrcPixelFormat { Unknown, RGBA8888, BGRA8888, RGB888, BGR888 };
+
+// Scanout formats - DRM fourcc naming, i.e. little-endian words (XRGB8888 = B,G,R,X in memory)
+enum class DstPixelFormat { Unknown, RGB565, BGR565, XRGB8888, XBGR8888 };
+
+// One scanline, src and dst must not overlap
+using ConvertRowFn = void (*)(const uint8_t* src, uint8_t* dst, int width);
+
+DstPixelFormat DstFormatFromVInfo(const fb_var_screeninfo& vinfo); // from channel offsets/lengths
+int SrcBytesPerPixel(SrcPixelFormat format);
+int DstBytesPerPixel(DstPixelFormat format);
+const char* PixelFormatName(SrcPixelFormat format);
+const char* PixelFormatName(DstPixelFormat format);
+
+// Kernel for src -> dst, swapRB exchanges red and blue on output (RGBOrder=1 panels)
+// nullptr if the pair has no kernel
+ConvertRowFn GetRowConverter(SrcPixelFormat src, DstPixelFormat dst, bool swapRB);
+
+// Convert a block of rows straight into the destination (e.g. mapped fb memory)
+void ConvertRows(ConvertRowFn convert,
+                 const uint8_t* src, int srcPitch,
+                 uint8_t* dst, int dstPitch,
+                 int width, int rows);
+
+const char* PixelKernelIsa(); // "neon", "ssse3", "sse2" or "scalar"
@@ -0,0 +1,172 @@
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/signalfd.h>
+#include <sys/timerfd.h>
+#include <errno.h>
+#include <pthread.h>
+#include <signal.h>
+#include <unistd.h>
+
+#include <cstring>
+
+#include "logger.h"
+#include "reactor.h"
+
+extern Logger gLogger; // declare external logger instance
+
+namespace {
+    itimerspec toSpec(std::chrono::milliseconds interval)
+    {
+        itimerspec spec{};
+        spec.it_interval.tv_sec = interval.count() / 1000;
+        spec.it_interval.tv_nsec = (interval.count() % 1000) * 1000000;
+        spec.it_value = spec.it_interval; // first expiry one interval from now
+        return spec;
+    }
+
+    void drain(int fd)
+    {
+        uint64_t v;
+        while (read(fd, &v, sizeof v) == sizeof v) {}
+    }
+}
+
+Reactor::Reactor()
+{
+    epollFd = epoll_create1(EPOLL_CLOEXEC);
+    wakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+
+    if (epollFd < 0 || wakeFd < 0) {
+        gLogger.log("Reactor: epoll/eventfd failed: ", strerror(errno));
+        return;
+    }
+
+    // only drained - returning from epoll_wait is the point
+    Add(wakeFd, EPOLLIN, [this](uint32_t) { drain(wakeFd); });
+}
+
+Reactor::~Reactor()
+{
+    for (int timer : timers) {
+        close(timer);
+    }
+    if (signalFd >= 0) close(signalFd);
+    if (wakeFd >= 0) close(wakeFd);
+    if (epollFd >= 0) close(epollFd);
+}
+
+bool Reactor::Add(int fd, uint32_t events, Handler handler)
+{
+    epoll_event ev{};
+    ev.events = events;
+    ev.data.fd = fd;
+
+    int op = handlers.count(fd) ? EPOLL_CTL_MOD : EPOLL_CTL_ADD;
+    if (epoll_ctl(epollFd, op, fd, &ev) < 0) {
+        gLogger.log("Reactor: cannot watch fd ", fd, ": ", strerror(errno));
+        return false;
+    }
+
+    handlers[fd] = std::move(handler);
+    return true;
+}
+
+void Reactor::Remove(int fd)
+{
+    if (handlers.erase(fd)) {
+        epoll_ctl(epollFd, EPOLL_CTL_DEL, fd, nullptr);
+    }
+}
+
+int Reactor::AddTimer(std::chrono::milliseconds interval, std::function<void()> handler)
+{
+    int fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    if (fd < 0) {
+        gLogger.log("Reactor: timerfd failed: ", strerror(errno));
+        return -1;
+    }
+
+    // missed expiries collapse into one call
+    Add(fd, EPOLLIN, [fd, handler = std::move(handler)](uint32_t) {
+        drain(fd);
+        handler();
+    });
+
+    SetTimer(fd, interval);
+    timers.insert(fd);
+    return fd;
+}
+
+void Reactor::SetTimer(int timer, std::chrono::milliseconds interval)
+{
+    itimerspec spec = toSpec(interval.count() > 0 ? interval : std::chrono::milliseconds(0));
+    timerfd_settime(timer, 0, &spec, nullptr);
+}
+
+void Reactor::RemoveTimer(int timer)
+{
+    if (timers.erase(timer)) {
+        Remove(timer);
+        close(timer);
+    }
+}
+
+bool Reactor::WatchSignals(std::initializer_list<int> signals, std::function<void(int)> handler)
+{
+    sigset_t mask;
+    sigemptyset(&mask);
+    for (int s : signals) {
+        sigaddset(&mask, s);
+    }
+
+    // threads inherit the mask, so the signals can only arrive through the signalfd
+    pthread_sigmask(SIG_BLOCK, &mask, nullptr);
+
+    signalFd = signalfd(-1, &mask, SFD_NONBLOCK | SFD_CLOEXEC);
+    if (signalFd < 0) {
+        gLogger.log("Reactor: signalfd failed: ", strerror(errno));
+        return false;
+    }
+
+    return Add(signalFd, EPOLLIN, [this, handler = std::move(handler)](uint32_t) {
+        signalfd_siginfo info;
+        while (read(signalFd, &info, sizeof info) == sizeof info) {
+            handler((int)info.ssi_signo);
+        }
+    });
+}
+
+void Reactor::Wake()
+{
+    uint64_t one = 1;
+    ssize_t n = write(wakeFd, &one, sizeof one);
+    (void)n; // counter full = a wake is pending anyway
+}
+
+int Reactor::RunOnce(int timeoutMs)
+{
+    epoll_event events[16];
+    int n = epoll_wait(epollFd, events, 16, timeoutMs);
+    stats.wakeups++;
+
+    if (n < 0) {
+        if (errno != EINTR) LOGW("Reactor: epoll_wait failed: ", strerror(errno));
+        return 0;
+    }
+
+    int ran = 0;
+    for (int i = 0; i < n; ++i)
+    {
+        auto it = handlers.find(events[i].data.fd);
+        if (it == handlers.end()) {
+            continue; // removed by an earlier handler of this round
+        }
+
+        Handler handler = it->second; // may remove itself
+        handler(events[i].events);
+        ran++;
+    }
+
+    stats.events += ran;
+    return ran;
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <initializer_list>
+#include <unordered_map>
+#include <unordered_set>
+
+//-------------------------------------------------------------------
+//* Main-thread event loop - epoll over fds, timerfd timers, an eventfd wake and a signalfd
+// Everything except Wake() is main-thread only. Handlers run inside RunOnce().
+class Reactor {
+public:
+    using Handler = std::function<void(uint32_t events)>; // EPOLLIN / EPOLLOUT / EPOLLERR ...
+
+    struct Stats {
+        uint64_t wakeups = 0; // epoll_wait returns
+        uint64_t events = 0;  // handlers run
+    };
+
+    Reactor();
+    ~Reactor();
+
+    Reactor(const Reactor&) = delete;
+    Reactor& operator=(const Reactor&) = delete;
+
+    bool Add(int fd, uint32_t events, Handler handler); // level triggered
+    void Remove(int fd);
+
+    // periodic timer, returns its id (a timerfd) or -1; interval 0 = created disarmed
+    int AddTimer(std::chrono::milliseconds interval, std::function<void()> handler);
+    void SetTimer(int timer, std::chrono::milliseconds interval); // re-arm from now, 0 = disarm
+    void RemoveTimer(int timer);
+
+    // block the signals for the whole process (call before starting threads), deliver them here
+    bool WatchSignals(std::initializer_list<int> signals, std::function<void(int)> handler);
+
+    void Wake(); // any thread: make the current / next RunOnce return
+
+    int RunOnce(int timeoutMs = -1); // sleeps until something happens, returns handlers run
+    Stats GetStats() const { return stats; }
+
+private:
+    int epollFd{-1};
+    int wakeFd{-1};   // eventfd
+    int signalFd{-1};
+    std::unordered_map<int, Handler> handlers;
+    std::unordered_set<int> timers; // timerfds we own
+    Stats stats;
+};
@@ -0,0 +1,398 @@
+// libhiredis-dev
+
+#include <hiredis/hiredis.h>
+#include <hiredis/async.h>
+
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <memory>
+
+#include "logger.h"
+#include "redis_async.h"
+
+extern Logger gLogger; // declare external logger instance
+
+
+RedisAsync::RedisAsync(const std::string_view host, int port)
+    : host(host), port(port)
+{
+}
+
+RedisAsync::~RedisAsync()
+{
+    Stop();
+}
+
+void RedisAsync::Start()
+{
+    if (ioThread.joinable()) {
+        return;
+    }
+
+    wakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    stop = false;
+    ioThread = std::thread(&RedisAsync::ioLoop, this);
+}
+
+void RedisAsync::Stop()
+{
+    if (!ioThread.joinable()) {
+        return;
+    }
+
+    stop = true;
+    wakeIo();
+    ioThread.join();
+
+    close(wakeFd);
+    wakeFd = -1;
+}
+
+void RedisAsync::Command(std::vector<std::string> args, Callback cb)
+{
+    {
+        std::lock_guard<std::mutex> lock(queueMtx);
+        queue.push_back(Pending{std::move(args), std::move(cb)});
+    }
+    wakeIo();
+}
+
+void RedisAsync::Pipeline(std::vector<std::vector<std::string>> commands)
+{
+    {
+        std::lock_guard<std::mutex> lock(queueMtx);
+        for (auto &c : commands) {
+            queue.push_back(Pending{std::move(c), nullptr});
+        }
+    }
+    wakeIo();
+}
+
+std::future<RedisAsync::Reply> RedisAsync::Command(std::vector<std::string> args)
+{
+    auto promise = std::make_shared<std::promise<Reply>>();
+    auto future = promise->get_future();
+    Command(std::move(args), [promise](const Reply &reply) { promise->set_value(reply); });
+    return future;
+}
+
+void RedisAsync::GetBinary(const std::string &key, size_t chunkBytes, BinaryCallback done)
+{
+    if (chunkBytes == 0) {
+        chunkBytes = 256 * 1024;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(binaryMtx);
+        binaryQueue.push_back(BinaryFetch{key, chunkBytes, std::move(done)});
+        if (binaryBusy) {
+            return; // started when the current one finishes
+        }
+        binaryBusy = true;
+    }
+    startNextBinary();
+}
+
+void RedisAsync::startNextBinary()
+{
+    BinaryFetch next;
+    std::deque<BinaryFetch> dropped;
+    {
+        std::lock_guard<std::mutex> lock(binaryMtx);
+        if (stop) {
+            dropped.swap(binaryQueue); // the I/O loop is gone, nothing would answer them
+        }
+        if (binaryQueue.empty()) {
+            binaryBusy = false;
+        } else {
+            next = std::move(binaryQueue.front());
+            binaryQueue.pop_front();
+        }
+    }
+    for (auto &f : dropped) {
+        f.done(false, {});
+    }
+    if (!next.done) {
+        return;
+    }
+
+    fetchWatched(next.key, next.chunkBytes, 3, [this, done = std::move(next.done)](bool ok, std::string data)
+    {
+        done(ok, std::move(data));
+        startNextBinary();
+    });
+}
+
+void RedisAsync::fetchWatched(const std::string &key, size_t chunkBytes, int retries, BinaryCallback done)
+{
+    Command({"WATCH", key}, nullptr);
+    Command({"STRLEN", key}, [this, key, chunkBytes, retries, done](const Reply &reply)
+    {
+        if (reply.type != REDIS_REPLY_INTEGER || reply.integer <= 0) {
+            Command({"UNWATCH"}, nullptr);
+            done(false, {}); // missing key, wrong type or not connected
+            return;
+        }
+
+        auto buf = std::make_shared<std::string>();
+        buf->reserve((size_t)reply.integer);
+        fetchRange(key, buf, (size_t)reply.integer, chunkBytes, retries, done);
+    });
+}
+
+// runs on the I/O thread: each reply is appended and queues the next range
+void RedisAsync::fetchRange(const std::string &key, std::shared_ptr<std::string> buf, size_t total,
+                            size_t chunkBytes, int retries, BinaryCallback done)
+{
+    auto retry = [this, key, chunkBytes, retries, done]
+    {
+        if (retries > 0) {
+            fetchWatched(key, chunkBytes, retries - 1, done);
+        } else {
+            done(false, {});
+        }
+    };
+
+    if (buf->size() == total)
+    {
+        // the WATCH since STRLEN turns EXEC into nil if anything wrote the key in between
+        Transaction({}, [buf, done, retry](const Reply &reply)
+        {
+            if (reply.type == REDIS_REPLY_ARRAY) {
+                done(true, std::move(*buf));
+            } else if (reply.type == REDIS_REPLY_NIL) {
+                retry();
+            } else {
+                done(false, {}); // link lost
+            }
+        });
+        return;
+    }
+
+    size_t start = buf->size();
+    size_t end = std::min(total, start + chunkBytes) - 1; // inclusive
+
+    Command({"GETRANGE", key, std::to_string(start), std::to_string(end)},
+        [this, key, buf, total, chunkBytes, retries, done, retry, want = end - start + 1](const Reply &reply)
+        {
+            if (reply.type != REDIS_REPLY_STRING) {
+                done(false, {}); // link lost
+                return;
+            }
+            if (reply.str.size() != want) // shrank under us
+            {
+                Command({"UNWATCH"}, nullptr);
+                retry();
+                return;
+            }
+
+            buf->append(reply.str);
+            fetchRange(key, buf, total, chunkBytes, retries, done);
+        });
+}
+
+void RedisAsync::Transaction(std::vector<std::vector<std::string>> commands, Callback cb)
+{
+    {
+        // one lock: submitQueued sends the block in order, without other callers' commands inside
+        std::lock_guard<std::mutex> lock(queueMtx);
+        queue.push_back(Pending{{"MULTI"}, nullptr});
+        for (auto &c : commands) {
+            queue.push_back(Pending{std::move(c), nullptr});
+        }
+        queue.push_back(Pending{{"EXEC"}, std::move(cb)});
+    }
+    wakeIo();
+}
+
+void RedisAsync::wakeIo()
+{
+    if (wakeFd >= 0) {
+        uint64_t one = 1;
+        (void)!write(wakeFd, &one, sizeof(one));
+    }
+}
+
+//-------------------------------------------------------------------
+//* I/O thread
+void RedisAsync::ioLoop()
+{
+    auto nextConnect = std::chrono::steady_clock::now();
+
+    while (!stop)
+    {
+        if (ac == nullptr && std::chrono::steady_clock::now() >= nextConnect) {
+            connect();
+            nextConnect = std::chrono::steady_clock::now() + std::chrono::seconds(2);
+        }
+
+        submitQueued();
+
+        pollfd fds[2] = {};
+        fds[0].fd = wakeFd;
+        fds[0].events = POLLIN;
+        fds[1].fd = ac ? ac->c.fd : -1; // negative fd: ignored by poll
+        fds[1].events = (short)((wantRead ? POLLIN : 0) | (wantWrite ? POLLOUT : 0));
+
+        int timeoutMs = ac ? -1 : 500; // only the reconnect timer needs a timeout
+        if (poll(fds, 2, timeoutMs) < 0) {
+            continue; // EINTR
+        }
+
+        if (fds[0].revents & POLLIN) {
+            uint64_t n;
+            (void)!read(wakeFd, &n, sizeof(n));
+        }
+
+        if (ac && (fds[1].revents & (POLLIN | POLLERR | POLLHUP))) {
+            redisAsyncHandleRead(ac); // may disconnect and clear ac
+        }
+        if (ac && (fds[1].revents & POLLOUT)) {
+            redisAsyncHandleWrite(ac);
+        }
+    }
+
+    if (ac) {
+        redisAsyncContext *c = ac;
+        ac = nullptr;
+        redisAsyncFree(c); // outstanding callbacks get a null reply
+    }
+    connected = false;
+
+    // nobody will serve these any more
+    std::deque<Pending> left;
+    {
+        std::lock_guard<std::mutex> lock(queueMtx);
+        left.swap(queue);
+    }
+    for (auto &p : left) {
+        if (p.cb) p.cb(Reply{});
+    }
+}
+
+void RedisAsync::connect()
+{
+    redisAsyncContext *c = redisAsyncConnect(host.c_str(), port);
+    if (c == nullptr || c->err)
+    {
+        if (c) redisAsyncFree(c);
+        return;
+    }
+
+    c->data = this;
+    c->ev.data = this;
+    c->ev.addRead = &RedisAsync::addRead;
+    c->ev.delRead = &RedisAsync::delRead;
+    c->ev.addWrite = &RedisAsync::addWrite;
+    c->ev.delWrite = &RedisAsync::delWrite;
+    c->ev.cleanup = &RedisAsync::cleanup;
+
+    redisAsyncSetConnectCallback(c, &RedisAsync::onConnect);
+    redisAsyncSetDisconnectCallback(c, &RedisAsync::onDisconnect);
+
+    ac = c;
+    wantWrite = true; // non-blocking connect completes on writable
+}
+
+void RedisAsync::submitQueued()
+{
+    std::deque<Pending> batch;
+    {
+        std::lock_guard<std::mutex> lock(queueMtx);
+        batch.swap(queue);
+    }
+
+    for (auto &p : batch)
+    {
+        if (ac == nullptr) {
+            if (p.cb) p.cb(Reply{}); // not connected: fail fast, never block the caller
+            continue;
+        }
+
+        std::vector<const char *> argv;
+        std::vector<size_t> argvlen;
+        for (const auto &a : p.args) {
+            argv.push_back(a.data());
+            argvlen.push_back(a.size());
+        }
+
+        auto *cb = new Callback(std::move(p.cb));
+        if (redisAsyncCommandArgv(ac, &RedisAsync::onReply, cb, (int)argv.size(), argv.data(), argvlen.data()) != REDIS_OK)
+        {
+            if (*cb) (*cb)(Reply{});
+            delete cb;
+        }
+    }
+}
+
+//static
+void RedisAsync::onReply(redisAsyncContext *, void *r, void *privdata)
+{
+    std::unique_ptr<Callback> cb(static_cast<Callback *>(privdata));
+    if (!cb || !*cb) {
+        return;
+    }
+
+    Reply out;
+    if (auto *reply = static_cast<redisReply *>(r))
+    {
+        out.type = reply->type;
+        out.ok = reply->type != REDIS_REPLY_ERROR;
+        switch (reply->type) {
+            case REDIS_REPLY_STRING:
+            case REDIS_REPLY_STATUS:
+            case REDIS_REPLY_ERROR:
+                out.str.assign(reply->str, reply->len);
+                break;
+            case REDIS_REPLY_INTEGER:
+                out.integer = reply->integer;
+                break;
+            case REDIS_REPLY_ARRAY:
+                for (size_t i = 0; i < reply->elements; ++i) {
+                    const redisReply *e = reply->element[i];
+                    out.elements.emplace_back(e->type == REDIS_REPLY_STRING ? std::string(e->str, e->len) : std::string());
+                }
+                break;
+        }
+    }
+    (*cb)(out);
+}
+
+//static
+void RedisAsync::onConnect(const redisAsyncContext *c, int status)
+{
+    auto *self = static_cast<RedisAsync *>(c->data);
+    if (status != REDIS_OK) {
+        gLogger.log("Async redis connect to ", self->host, ":", self->port, " failed: ", c->errstr);
+        self->ac = nullptr; // hiredis frees the context
+        return;
+    }
+    gLogger.log("Async redis connected to ", self->host, ":", self->port);
+    self->connected = true;
+}
+
+//static
+void RedisAsync::onDisconnect(const redisAsyncContext *c, int status)
+{
+    auto *self = static_cast<RedisAsync *>(c->data);
+    if (status != REDIS_OK) {
+        gLogger.log("Async redis connection lost: ", c->errstr);
+    }
+    self->ac = nullptr;
+    self->connected = false;
+}
+
+// poll adapter - the I/O loop reads these flags when building its pollfd
+void RedisAsync::addRead(void *data)  { static_cast<RedisAsync *>(data)->wantRead = true; }
+void RedisAsync::delRead(void *data)  { static_cast<RedisAsync *>(data)->wantRead = false; }
+void RedisAsync::addWrite(void *data) { static_cast<RedisAsync *>(data)->wantWrite = true; }
+void RedisAsync::delWrite(void *data) { static_cast<RedisAsync *>(data)->wantWrite = false; }
+void RedisAsync::cleanup(void *data)
+{
+    auto *self = static_cast<RedisAsync *>(data);
+    self->wantRead = self->wantWrite = false;
+}
@@ -0,0 +1,102 @@
+// libhiredis-dev
+
+#pragma once
+
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+struct redisAsyncContext;
+
+//-------------------------------------------------------------------
+//* Non-blocking redis client - hiredis async API on its own I/O thread
+// Built-in poll() adapter (no libevent). Callbacks run on the I/O thread.
+class RedisAsync {
+public:
+    struct Reply {
+        bool ok = false;  // false: not connected / connection lost / error reply
+        int type = 0;     // REDIS_REPLY_*
+        std::string str;  // STRING, STATUS, ERROR (binary safe)
+        long long integer = 0;
+        std::vector<std::string> elements; // ARRAY of strings
+    };
+    using Callback = std::function<void(const Reply &reply)>;
+    using BinaryCallback = std::function<void(bool ok, std::string data)>;
+
+    RedisAsync(const std::string_view host, int port);
+    ~RedisAsync();
+
+    void Start();
+    void Stop();
+    bool isConnected() const { return connected; }
+
+    void Command(std::vector<std::string> args, Callback cb); // cb may be nullptr: fire and forget
+    void Pipeline(std::vector<std::vector<std::string>> commands); // fire and forget, sent in one write
+    std::future<Reply> Command(std::vector<std::string> args);
+
+    // MULTI + EXEC: nothing else on this connection runs in between, cb gets EXEC's reply
+    void Transaction(std::vector<std::vector<std::string>> commands, Callback cb);
+
+    // WATCH + STRLEN, then GETRANGE chunk by chunk (no reply larger than chunkBytes), then an
+    // empty MULTI/EXEC: nil = the value was written meanwhile, read it again. One at a time -
+    // EXEC drops every WATCH on the connection.
+    void GetBinary(const std::string &key, size_t chunkBytes, BinaryCallback done);
+
+private:
+    struct Pending {
+        std::vector<std::string> args;
+        Callback cb;
+    };
+
+    struct BinaryFetch {
+        std::string key;
+        size_t chunkBytes = 0;
+        BinaryCallback done;
+    };
+
+    void startNextBinary();
+    void fetchWatched(const std::string &key, size_t chunkBytes, int retries, BinaryCallback done);
+    void fetchRange(const std::string &key, std::shared_ptr<std::string> buf, size_t total,
+                    size_t chunkBytes, int retries, BinaryCallback done);
+
+    void ioLoop();
+    void connect();
+    void submitQueued();
+    void wakeIo();
+
+    // hiredis hooks
+    static void onReply(redisAsyncContext *ac, void *reply, void *privdata);
+    static void onConnect(const redisAsyncContext *ac, int status);
+    static void onDisconnect(const redisAsyncContext *ac, int status);
+    static void addRead(void *data);
+    static void delRead(void *data);
+    static void addWrite(void *data);
+    static void delWrite(void *data);
+    static void cleanup(void *data);
+
+    std::string host;
+    int port;
+
+    std::thread ioThread;
+    std::atomic<bool> stop{false};
+    std::atomic<bool> connected{false};
+    int wakeFd{-1}; // eventfd: new commands / stop
+
+    // I/O thread only
+    redisAsyncContext *ac{nullptr};
+    bool wantRead{false};
+    bool wantWrite{false};
+
+    std::mutex queueMtx;
+    std::deque<Pending> queue;
+
+    std::mutex binaryMtx;
+    std::deque<BinaryFetch> binaryQueue; // waiting for the one in flight
+    bool binaryBusy{false};
+};
@@ -0,0 +1,328 @@
+// libhiredis-dev
+
+#include <hiredis/hiredis.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <sstream>
+
+#include "json11.hpp"
+#include "logger.h"
+#include "redis_cmdqueue.h"
+
+extern Logger gLogger; // declare external logger instance
+
+namespace {
+    constexpr const char *kClaimTimeout = "1"; // s, BLMOVE wait - bounds Stop() latency
+    constexpr const char *kResponseTtl = "60"; // s, unread answers expire
+    constexpr const char *kDoneTtl = "3600";   // s, how long a retried id is recognised
+    constexpr size_t kRecentIds = 1024;
+}
+
+RedisCommandQueue::RedisCommandQueue(const std::string_view host, int port, const std::string &key, int maxBatch)
+    : conn(host, port), key(key), processingKey(key + ":processing:default"), maxBatch(maxBatch < 1 ? 1 : maxBatch)
+{
+}
+
+void RedisCommandQueue::SetConsumer(const std::string &name)
+{
+    processingKey = key + ":processing:" + name;
+}
+
+RedisCommandQueue::~RedisCommandQueue()
+{
+    Stop();
+}
+
+void RedisCommandQueue::Start(Handler handler)
+{
+    if (thread.joinable()) {
+        return;
+    }
+
+    this->handler = std::move(handler);
+    stop = false;
+    thread = std::thread(&RedisCommandQueue::loop, this);
+}
+
+void RedisCommandQueue::Stop()
+{
+    stop = true; // the blocking claim returns within kClaimTimeout
+
+    if (thread.joinable()) {
+        thread.join();
+    }
+}
+
+RedisCommandQueue::Stats RedisCommandQueue::GetStats() const
+{
+    Stats s;
+    s.batches = batches;
+    s.commands = commands;
+    s.duplicates = duplicates;
+    s.requeued = requeued;
+    return s;
+}
+
+void RedisCommandQueue::loop()
+{
+    bool linked = false;
+
+    while (!stop)
+    {
+        if (!conn.isConnected())
+        {
+            if (linked) {
+                gLogger.log("Command queue ", key, " lost its connection, reconnecting");
+                linked = false;
+            }
+
+            if (!conn.Reconnect())
+            {
+                // retry every 2 seconds, checking for shutdown in between
+                for (int i = 0; i < 20 && !stop; ++i) {
+                    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+                }
+                continue;
+            }
+        }
+
+        if (!linked)
+        {
+            linked = true;
+            requeueProcessing(); // claimed by a previous run / connection but never answered
+            gLogger.log("Command queue listening on ", key);
+        }
+
+        std::vector<Command> batch = claim();
+        if (batch.empty()) {
+            continue;
+        }
+
+        std::vector<bool> duplicate(batch.size(), false);
+        markDuplicates(batch, duplicate);
+
+        std::vector<Command> run;
+        for (size_t i = 0; i < batch.size(); ++i) {
+            if (!duplicate[i]) run.push_back(batch[i]);
+        }
+
+        std::vector<std::string> answers;
+        if (!run.empty() && !dispatch(run, answers)) {
+            break; // stopping before the handler finished - the batch stays in the processing list
+        }
+
+        for (const auto &c : run) {
+            remember(c.id);
+        }
+
+        // answers back to batch positions
+        std::vector<std::string> responses(batch.size());
+        for (size_t i = 0, r = 0; i < batch.size(); ++i) {
+            if (!duplicate[i]) responses[i] = answers[r++];
+        }
+
+        ack(batch, duplicate, responses);
+
+        batches++;
+        commands += run.size();
+    }
+}
+
+void RedisCommandQueue::requeueProcessing()
+{
+    auto [len, type] = conn.Query("LLEN %s", processingKey);
+    long n = type == REDIS_REPLY_INTEGER ? std::stol(len) : 0;
+    if (n <= 0) {
+        return;
+    }
+
+    // newest claim first to the consuming end, so the oldest is taken first again
+    RedisBatch moves;
+    for (long i = 0; i < n; ++i) {
+        moves.Command({"LMOVE", processingKey, key, "LEFT", "RIGHT"});
+    }
+    conn.Exec(moves);
+
+    requeued += n;
+    gLogger.log("Command queue ", key, ": requeued ", n, " unanswered command(s)");
+}
+
+std::vector<RedisCommandQueue::Command> RedisCommandQueue::claim()
+{
+    std::vector<Command> batch;
+
+    auto first = conn.Exec(RedisBatch().Command({"BLMOVE", key, processingKey, "RIGHT", "LEFT", kClaimTimeout}));
+    auto &[payload, type] = first[0];
+
+    if (type == REDIS_REPLY_ERROR)
+    {
+        gLogger.log("Command queue ", key, ": BLMOVE failed (", payload, ") - redis >= 6.2 needed");
+        for (int i = 0; i < 20 && !stop; ++i) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        }
+        return batch;
+    }
+    if (type != REDIS_REPLY_STRING) {
+        return batch; // timed out, nothing queued
+    }
+    batch.push_back(parse(payload));
+
+    // whatever else is waiting comes along in one more round trip (empty list: nil replies)
+    if (maxBatch > 1)
+    {
+        RedisBatch more;
+        for (int i = 1; i < maxBatch; ++i) {
+            more.Command({"LMOVE", key, processingKey, "RIGHT", "LEFT"});
+        }
+        for (auto &[next, nextType] : conn.Exec(more))
+        {
+            if (nextType != REDIS_REPLY_STRING) break;
+            batch.push_back(parse(next));
+        }
+    }
+
+    return batch;
+}
+
+void RedisCommandQueue::markDuplicates(const std::vector<Command> &batch, std::vector<bool> &duplicate)
+{
+    RedisBatch exists;
+    std::vector<size_t> asked;
+    std::unordered_set<std::string> seen;
+
+    for (size_t i = 0; i < batch.size(); ++i)
+    {
+        const std::string &id = batch[i].id;
+        if (id.empty()) {
+            continue;
+        }
+
+        if (recentIds.count(id) || !seen.insert(id).second) {
+            duplicate[i] = true;
+            continue;
+        }
+        exists.Command({"EXISTS", key + ":done:" + id});
+        asked.push_back(i);
+    }
+
+    auto replies = conn.Exec(exists);
+    for (size_t k = 0; k < asked.size(); ++k)
+    {
+        auto &[count, type] = replies[k];
+        if (type == REDIS_REPLY_INTEGER && count != "0") {
+            duplicate[asked[k]] = true;
+        }
+    }
+
+    for (size_t i = 0; i < batch.size(); ++i) {
+        if (duplicate[i]) duplicates++;
+    }
+}
+
+bool RedisCommandQueue::dispatch(const std::vector<Command> &batch, std::vector<std::string> &responses)
+{
+    // shared with done(), which may outlive a stopped wait
+    struct Completion {
+        std::mutex mtx;
+        std::condition_variable cv;
+        bool done = false;
+        std::vector<std::string> responses;
+    };
+    auto completion = std::make_shared<Completion>();
+
+    handler(batch, [completion](std::vector<std::string> responses)
+    {
+        {
+            std::lock_guard<std::mutex> lock(completion->mtx);
+            completion->responses = std::move(responses);
+            completion->done = true;
+        }
+        completion->cv.notify_one();
+    });
+
+    std::unique_lock<std::mutex> lock(completion->mtx);
+    while (!completion->done)
+    {
+        if (stop) {
+            return false;
+        }
+        completion->cv.wait_for(lock, std::chrono::milliseconds(100));
+    }
+
+    responses = std::move(completion->responses);
+    responses.resize(batch.size());
+    return true;
+}
+
+void RedisCommandQueue::ack(const std::vector<Command> &batch, const std::vector<bool> &duplicate,
+                            const std::vector<std::string> &responses)
+{
+    // answers, done markers and the removal from the processing list land together or not at all
+    RedisBatch tx;
+    tx.Command({"MULTI"});
+
+    for (size_t i = 0; i < batch.size(); ++i)
+    {
+        const Command &c = batch[i];
+        if (!duplicate[i] && !c.id.empty())
+        {
+            std::string responseKey = key + ":response:" + c.id;
+            tx.Command({"LPUSH", responseKey, responses[i]})
+              .Command({"EXPIRE", responseKey, kResponseTtl})
+              .Command({"SET", key + ":done:" + c.id, "1", "EX", kDoneTtl});
+        }
+        tx.Command({"LREM", processingKey, "1", c.raw});
+    }
+
+    tx.Command({"EXEC"});
+    conn.Exec(tx);
+}
+
+void RedisCommandQueue::remember(const std::string &id)
+{
+    if (id.empty() || !recentIds.insert(id).second) {
+        return;
+    }
+
+    recentOrder.push_back(id);
+    if (recentOrder.size() > kRecentIds)
+    {
+        recentIds.erase(recentOrder.front());
+        recentOrder.pop_front();
+    }
+}
+
+//static
+RedisCommandQueue::Command RedisCommandQueue::parse(const std::string &payload)
+{
+    Command c;
+    c.raw = payload;
+
+    std::string err;
+    json11::Json j = json11::Json::parse(payload, err);
+
+    if (err.empty() && j.is_object())
+    {
+        if (j["id"].is_string()) c.id = j["id"].string_value();
+        else if (j["id"].is_number()) c.id = std::to_string((long long)j["id"].number_value());
+
+        c.cmd = j["cmd"].string_value();
+        for (const auto &a : j["args"].array_items()) {
+            c.args.push_back(a.is_string() ? a.string_value() : a.dump());
+        }
+    }
+    else
+    {
+        // bare "cmd arg ..." - fire and forget
+        std::istringstream words(payload);
+        words >> c.cmd;
+        for (std::string a; words >> a; ) {
+            c.args.push_back(a);
+        }
+    }
+
+    return c;
+}
@@ -0,0 +1,75 @@
+// libhiredis-dev
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <string>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+
+#include "redis_conn.h"
+
+//-------------------------------------------------------------------
+//* Reliable remote command queue - BLMOVE from a redis list on its own connection and thread
+// Producers LPUSH {"id":"..","cmd":"..","args":[..]} (or a bare "cmd arg ...") to KEY.
+// Claimed commands sit in KEY:processing:<consumer> until answered, so nothing is lost if the
+// link or the device dies mid-batch - leftovers go back to KEY on the next (re)connect. The list
+// is per consumer: viewers sharing KEY never requeue each other's commands in flight.
+// Answers: LPUSH KEY:response:<id> (producer BLPOPs it). Answered ids are remembered in
+// KEY:done:<id>, so a producer retrying the same id runs it only once. Needs redis >= 6.2.
+class RedisCommandQueue {
+public:
+    struct Command {
+        std::string id;  // empty: no answer, no duplicate check
+        std::string cmd;
+        std::vector<std::string> args;
+        std::string raw; // payload as queued (LREM needs it)
+    };
+    using Done = std::function<void(std::vector<std::string> responses)>; // one per command, in order
+    using Handler = std::function<void(const std::vector<Command> &batch, Done done)>;
+
+    struct Stats {
+        uint64_t batches = 0;
+        uint64_t commands = 0;
+        uint64_t duplicates = 0; // skipped, id already answered
+        uint64_t requeued = 0;   // picked up from KEY:processing:<consumer> after a restart / link loss
+    };
+
+    RedisCommandQueue(const std::string_view host, int port, const std::string &key, int maxBatch = 32);
+    ~RedisCommandQueue();
+
+    void SetConsumer(const std::string &name); // before Start - unique per viewer, stable across restarts
+    void Start(Handler handler); // handler runs on the queue thread, done() may be called from any thread
+    void Stop();
+    Stats GetStats() const;
+
+private:
+    void loop();
+    void requeueProcessing();
+    std::vector<Command> claim();
+    void markDuplicates(const std::vector<Command> &batch, std::vector<bool> &duplicate);
+    bool dispatch(const std::vector<Command> &batch, std::vector<std::string> &responses);
+    void ack(const std::vector<Command> &batch, const std::vector<bool> &duplicate,
+             const std::vector<std::string> &responses);
+    void remember(const std::string &id);
+    static Command parse(const std::string &payload);
+
+    RedisConnect conn; // blocking connection, used by the queue thread only
+    std::string key;
+    std::string processingKey;
+    int maxBatch;
+
+    Handler handler;
+    std::thread thread;
+    std::atomic<bool> stop{false};
+
+    // ids executed by this process - covers the gap between running and the ack reaching redis
+    std::unordered_set<std::string> recentIds;
+    std::deque<std::string> recentOrder;
+
+    std::atomic<uint64_t> batches{0}, commands{0}, duplicates{0}, requeued{0};
+};
@@ -18,6 +18,11 @@ RedisConnect::RedisConnect(const std::string_view host, int port)
     // must connect explicitly later
 }
 
+RedisConnect::~RedisConnect()
+{
+    Unsubscribe();
+}
+
 bool RedisConnect::Connect() 
 {
     bool ok = tryConnect();
@@ -29,6 +34,11 @@ bool RedisConnect::Connect()
     return true;
 }
 
+bool RedisConnect::Reconnect()
+{
+    return tryConnect();
+}
+
 bool RedisConnect::tryConnect() 
 {
     context.reset(redisConnect(host.c_str(), port));
@@ -83,6 +93,7 @@ bool RedisConnect::retryConnect(int maxTries, int intervalSeconds)
 
 void RedisConnect::Disconnect()
 {
+    Unsubscribe();
     context.reset();
 
     gLogger.log("Disconnected from Redis at ", host, ":", port);
@@ -103,27 +114,28 @@ std::string RedisConnect::GetString(const std::string &key, bool log)
 
     if (!isConnected()) 
     {
-        println("Not connected to Redis");
+        PRINTW("Not connected to Redis");
         return value;
     }
 
+    roundTrips++;
     redisReply *reply = (redisReply *)redisCommand(context.get(), "GET %s", key.c_str());        
     if (reply != NULL) 
     {
         if (reply->type == REDIS_REPLY_STRING) 
         {
-            value = reply->str;
+            value.assign(reply->str, reply->len); // binary safe
         } 
         else 
         {
-            if(log) println("Redis key:", key, ",not found or not a string");
+            if(log) PRINTI("Redis key:", key, ",not found or not a string");
         }
 
         freeReplyObject(reply);
     }
     else 
     {
-        println("Failed to execute GET command for key:", key);
+        PRINTW("Failed to execute GET command for key:", key);
     }
     return value;
 }
@@ -132,10 +144,11 @@ bool RedisConnect::SetString(const std::string &key, const std::string &value)
 {
     if (!isConnected()) 
     {
-        println("Not connected to Redis");
+        PRINTW("Not connected to Redis");
         return false;
     }
 
+    roundTrips++;
     redisReply *reply = (redisReply *)redisCommand(context.get(), "SET %s %s", key.c_str(), value.c_str());
     bool success = false;
     
@@ -148,7 +161,7 @@ bool RedisConnect::SetString(const std::string &key, const std::string &value)
     }
     else 
     {
-        println("Failed to execute SET command for key:", key);
+        PRINTW("Failed to execute SET command for key:", key);
     }
     
     return success;
@@ -157,10 +170,11 @@ bool RedisConnect::SetString(const std::string &key, const std::string &value)
 bool RedisConnect::Delete(const std::string &key)
 {
     if (!isConnected()) {
-        println("Not connected to Redis");
+        PRINTW("Not connected to Redis");
         return false;
     }
 
+    roundTrips++;
     redisReply *reply = (redisReply *)redisCommand(context.get(), "DEL %s", key.c_str());
     bool success = false;
     
@@ -173,12 +187,45 @@ bool RedisConnect::Delete(const std::string &key)
     }
     else 
     {
-        println("Failed to execute DEL command for key:", key);
+        PRINTW("Failed to execute DEL command for key:", key);
     }
     
     return success;
 }
 
+std::vector<std::string> RedisConnect::GetList(const std::string &key, int start, int stop)
+{
+    std::vector<std::string> items;
+
+    if (!isConnected()) {
+        PRINTW("Not connected to Redis");
+        return items;
+    }
+
+    roundTrips++;
+    redisReply *reply = (redisReply *)redisCommand(context.get(), "LRANGE %s %d %d", key.c_str(), start, stop);
+
+    if (reply != NULL) 
+    {
+        if (reply->type == REDIS_REPLY_ARRAY) 
+        {
+            for (size_t i = 0; i < reply->elements; i++) 
+            {
+                if (reply->element[i]->type == REDIS_REPLY_STRING) {
+                    items.emplace_back(reply->element[i]->str, reply->element[i]->len);
+                }
+            }
+        }
+        freeReplyObject(reply);
+    }
+    else 
+    {
+        PRINTW("Failed to execute LRANGE command for key:", key);
+    }
+
+    return items;
+}
+
 // SET, DEL, etc ..
 std::tuple<std::string, int> RedisConnect::Query(std::string command, std::string args) 
 {
@@ -186,10 +233,11 @@ std::tuple<std::string, int> RedisConnect::Query(std::string command, std::strin
     int type = 0;  
 
     if (!isConnected()) {
-        println("Not connected to Redis");
+        PRINTW("Not connected to Redis");
         return {result, type};
     }
 
+    roundTrips++;
     redisReply *reply = (redisReply *)redisCommand(context.get(), command.c_str(), args.c_str());
     
     if (reply != NULL) 
@@ -211,3 +259,52 @@ std::tuple<std::string, int> RedisConnect::Query(std::string command, std::strin
     
     return {result, type};
 }
+
+std::vector<std::tuple<std::string, int>> RedisConnect::Exec(const RedisBatch &batch)
+{
+    std::vector<std::tuple<std::string, int>> results(batch.size(), {"", 0});
+
+    if (!isConnected()) {
+        PRINTW("Not connected to Redis");
+        return results;
+    }
+    if (batch.empty()) {
+        return results;
+    }
+
+    // queue everything in the output buffer, the first GetReply flushes it in one go
+    for (const auto &cmd : batch.Commands())
+    {
+        std::vector<const char *> argv;
+        std::vector<size_t> argvlen;
+        for (const auto &a : cmd) {
+            argv.push_back(a.data());
+            argvlen.push_back(a.size());
+        }
+        redisAppendCommandArgv(context.get(), (int)argv.size(), argv.data(), argvlen.data());
+    }
+    roundTrips++;
+
+    for (size_t i = 0; i < batch.size(); i++)
+    {
+        void *r = nullptr;
+        if (redisGetReply(context.get(), &r) != REDIS_OK) {
+            PRINTW("Failed to read pipelined reply ", i, " of ", batch.size());
+            break; // context is in error state now, remaining replies are lost
+        }
+
+        redisReply *reply = (redisReply *)r;
+        int type = reply->type;
+        std::string result;
+        if (type == REDIS_REPLY_STRING || type == REDIS_REPLY_STATUS || type == REDIS_REPLY_ERROR) {
+            result.assign(reply->str, reply->len);
+        }
+        else if (type == REDIS_REPLY_INTEGER) {
+            result = std::to_string(reply->integer);
+        }
+        results[i] = {result, type};
+        freeReplyObject(reply);
+    }
+
+    return results;
+}
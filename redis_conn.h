@@ -1,10 +1,34 @@
 // libhiredis-dev
 
+#pragma once
+
 #include <hiredis/hiredis.h>
 
+#include <atomic>
+#include <cstdint>
+#include <functional>
 #include <memory>
+#include <mutex>
 #include <string>
+#include <thread>
+#include <vector>
+
+
+// Commands collected locally, sent in one round trip by RedisConnect::Exec
+class RedisBatch {
+public:
+    RedisBatch& Command(std::vector<std::string> args) { commands.push_back(std::move(args)); return *this; }
+    RedisBatch& Get(const std::string &key) { return Command({"GET", key}); }
+    RedisBatch& Set(const std::string &key, const std::string &value) { return Command({"SET", key, value}); }
+    RedisBatch& Delete(const std::string &key) { return Command({"DEL", key}); }
+
+    size_t size() const { return commands.size(); }
+    bool empty() const { return commands.empty(); }
+    const std::vector<std::vector<std::string>>& Commands() const { return commands; }
 
+private:
+    std::vector<std::vector<std::string>> commands;
+};
 
 class RedisConnect {
 private:
@@ -19,15 +43,36 @@ private:
     std::unique_ptr<redisContext, RedisContextDeleter> context;
     std::string host;
     int port;
+    uint64_t roundTrips = 0; // request/reply exchanges on the main connection
 
     bool tryConnect();
     bool retryConnect(int maxTries, int intervalSeconds);
 
+public:
+    using MessageFn = std::function<void(const std::string &channel, const std::string &message)>;
+    using StateFn = std::function<void(bool subscribed)>;
+private:
+    // subscription - own connection, own thread (a subscribed context can't run commands)
+    std::unique_ptr<redisContext, RedisContextDeleter> subContext;
+    std::thread subThread;
+    std::atomic<bool> subscribed{false};
+    std::atomic<bool> stopSub{false};
+    int subFd = -1; // under subFdMtx: closed only with it held, so Unsubscribe never hits a reused fd
+    std::mutex subFdMtx;
+    std::vector<std::string> subChannels;
+    bool subPattern = false;
+    MessageFn onMessage;
+    StateFn onState;
+
+    void subscriptionLoop();
+    bool subscribeOnce(); // connect + (P)SUBSCRIBE, then read until the link drops
+
 public:
     RedisConnect(const std::string_view host, int port);
-    ~RedisConnect() = default;
+    ~RedisConnect();
 
     bool Connect();
+    bool Reconnect(); // single attempt, for callers running their own retry loop
     void Disconnect();
     bool isConnected() const;
     std::tuple<std::string, int> GetHost() const; // host, port
@@ -35,5 +80,16 @@ public:
     std::string GetString(const std::string &key, bool log = false); // GET
     bool SetString(const std::string &key, const std::string &value); // SET
     bool Delete(const std::string &key); // DEL    
+    std::vector<std::string> GetList(const std::string &key, int start, int stop); // LRANGE
+
+    // SUBSCRIBE / PSUBSCRIBE on a second connection, reconnects until Unsubscribe
+    bool Subscribe(const std::vector<std::string> &channels, bool pattern, MessageFn onMessage, StateFn onState = nullptr);
+    void Unsubscribe();
+    bool isSubscribed() const { return subscribed; }
+    bool EnableKeyspaceEvents(bool configSet); // notify-keyspace-events has K and $? configSet = CONFIG SET it if not
     std::tuple<std::string, int> Query(std::string command, std::string args); // Generic command
+
+    // Pipelined: every command of the batch in one write, replies read back in order
+    std::vector<std::tuple<std::string, int>> Exec(const RedisBatch &batch); // {result, type} per command
+    uint64_t RoundTrips() const { return roundTrips; }
 };
\ No newline at end of file
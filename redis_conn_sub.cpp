@@ -0,0 +1,165 @@
+// libhiredis-dev
+
+#include <hiredis/hiredis.h>
+
+#include <sys/socket.h>
+
+#include <chrono>
+#include <string>
+#include <thread>
+
+#include "logger.h"
+#include "redis_conn.h"
+
+extern Logger gLogger; // declare external logger instance
+
+
+bool RedisConnect::Subscribe(const std::vector<std::string> &channels, bool pattern, MessageFn onMessage, StateFn onState)
+{
+    Unsubscribe();
+    if (channels.empty()) {
+        return false;
+    }
+
+    subChannels = channels;
+    subPattern = pattern;
+    this->onMessage = std::move(onMessage);
+    this->onState = std::move(onState);
+
+    stopSub = false;
+    subThread = std::thread(&RedisConnect::subscriptionLoop, this);
+    return true;
+}
+
+void RedisConnect::Unsubscribe()
+{
+    stopSub = true;
+
+    // unblock redisGetReply in the subscriber thread
+    {
+        std::lock_guard<std::mutex> lock(subFdMtx);
+        if (subFd >= 0) {
+            shutdown(subFd, SHUT_RDWR);
+        }
+    }
+
+    if (subThread.joinable()) {
+        subThread.join();
+    }
+}
+
+void RedisConnect::subscriptionLoop()
+{
+    while (!stopSub)
+    {
+        subscribeOnce(); // returns when the link drops
+
+        if (subscribed.exchange(false))
+        {
+            gLogger.log("Subscription to ", subChannels.front(), " lost, polling until it is back");
+            if (onState) onState(false);
+        }
+
+        // retry every 2 seconds, checking for shutdown in between
+        for (int i = 0; i < 20 && !stopSub; ++i) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        }
+    }
+}
+
+bool RedisConnect::subscribeOnce()
+{
+    subContext.reset(redisConnect(host.c_str(), port));
+    if (!subContext || subContext->err) {
+        subContext.reset();
+        return false;
+    }
+    {
+        std::lock_guard<std::mutex> lock(subFdMtx);
+        subFd = subContext->fd;
+    }
+
+    // one confirmation per channel: the first is the reply, the rest arrive as messages
+    // with an integer payload, which the read loop skips
+    std::vector<const char *> argv{subPattern ? "PSUBSCRIBE" : "SUBSCRIBE"};
+    for (const auto &ch : subChannels) {
+        argv.push_back(ch.c_str());
+    }
+    redisReply *reply = (redisReply *)redisCommandArgv(subContext.get(), (int)argv.size(), argv.data(), nullptr);
+    bool ok = reply != NULL && reply->type == REDIS_REPLY_ARRAY;
+    if (reply) freeReplyObject(reply);
+
+    if (ok && !stopSub)
+    {
+        for (const auto &ch : subChannels) {
+            gLogger.log("Subscribed to ", subPattern ? "pattern " : "channel ", ch);
+        }
+        subscribed = true;
+        if (onState) onState(true);
+
+        // message:  [message, channel, payload]
+        // pmessage: [pmessage, pattern, channel, payload]
+        void *r = nullptr;
+        while (!stopSub && redisGetReply(subContext.get(), &r) == REDIS_OK)
+        {
+            reply = (redisReply *)r;
+            if (reply && reply->type == REDIS_REPLY_ARRAY && reply->elements >= 3)
+            {
+                size_t n = reply->elements;
+                redisReply *ch = reply->element[n - 2];
+                redisReply *msg = reply->element[n - 1];
+                if (onMessage && ch->type == REDIS_REPLY_STRING && msg->type == REDIS_REPLY_STRING) {
+                    onMessage(std::string(ch->str, ch->len), std::string(msg->str, msg->len));
+                }
+            }
+            if (reply) freeReplyObject(reply);
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(subFdMtx);
+    subFd = -1;
+    subContext.reset();
+    return ok;
+}
+
+bool RedisConnect::EnableKeyspaceEvents(bool configSet)
+{
+    if (!isConnected()) {
+        return false;
+    }
+
+    roundTrips++;
+    redisReply *reply = (redisReply *)redisCommand(context.get(), "CONFIG GET notify-keyspace-events");
+    std::string current;
+    if (reply && reply->type == REDIS_REPLY_ARRAY && reply->elements == 2 &&
+        reply->element[1]->type == REDIS_REPLY_STRING) {
+        current = reply->element[1]->str;
+    }
+    if (reply) freeReplyObject(reply);
+
+    bool hasK = current.find('K') != std::string::npos;
+    bool hasString = current.find('$') != std::string::npos || current.find('A') != std::string::npos;
+    if (hasK && hasString) {
+        return true;
+    }
+
+    std::string wanted = current;
+    if (!hasK) wanted += 'K';
+    if (!hasString) wanted += '$';
+
+    if (!configSet)
+    {
+        gLogger.log("Keyspace notifications are off on the server (notify-keyspace-events=", current,
+                    "), image changes are only seen by polling - set notify-keyspace-events ", wanted,
+                    " on the server or KeyspaceConfigSet=1");
+        return false;
+    }
+
+    roundTrips++;
+    reply = (redisReply *)redisCommand(context.get(), "CONFIG SET notify-keyspace-events %s", wanted.c_str());
+    bool ok = reply && reply->type == REDIS_REPLY_STATUS;
+    if (reply) freeReplyObject(reply);
+
+    gLogger.log(ok ? "Enabled" : "Could not enable", " keyspace notifications (notify-keyspace-events=", wanted, ")");
+    return ok;
+}
@@ -9,6 +9,7 @@ import json
 import time
 import sys
 import threading
+import uuid
 from datetime import datetime
 
 class RedisConsole:
@@ -21,6 +22,8 @@ class RedisConsole:
             'help': self.show_help,
             'status': self.get_status,
             'set_image': self.set_image,
+            'show': self.show_image,
+            'cmd': self.send_raw_command,
             'get_image': self.get_current_image,
             'list_images': self.list_available_images,
             'config': self.show_config,
@@ -48,6 +51,16 @@ class RedisConsole:
             print(f"✗ Failed to connect to Redis: {e}")
             return False
 
+    def send_command(self, cmd, args=None, timeout=2):
+        """Queue a command for the application and wait for its answer"""
+        command_id = uuid.uuid4().hex
+        payload = json.dumps({"id": command_id, "cmd": cmd, "args": args or []})
+        self.redis_client.lpush("App:Commands", payload)
+
+        # answer is pushed once the app ran it; a retry with the same id is not run twice
+        reply = self.redis_client.blpop(f"App:Commands:response:{command_id}", timeout=timeout)
+        return reply[1] if reply else None
+
     def show_help(self, args=None):
         """Show available commands"""
         help_text = """
@@ -57,6 +70,8 @@ class RedisConsole:
 ║  help                - Show this help message               ║
 ║  status              - Get application status               ║
 ║  set_image <id>      - Set current image by ID (0-5)       ║
+║  show <id>           - Display image now (command queue)   ║
+║  cmd <name> [args]   - Send any command, wait for answer   ║
 ║  get_image           - Get current image ID                 ║
 ║  list_images         - List available images               ║
 ║  config              - Show application configuration       ║
@@ -102,8 +117,11 @@ class RedisConsole:
                 print(f"✓ Set current image to: img{image_id}.png")
                 
                 # Set command for application to refresh
-                self.redis_client.set("App:Command", "refresh")
-                print("✓ Sent refresh command to application")
+                answer = self.send_command("refresh")
+                if answer is not None:
+                    print(f"✓ Sent refresh command to application ({answer})")
+                else:
+                    print("⚠ Refresh queued, no answer yet (application not running?)")
             else:
                 print("✗ Invalid image ID. Use 0-5")
         except ValueError:
@@ -111,6 +129,33 @@ class RedisConsole:
         except Exception as e:
             print(f"✗ Error setting image: {e}")
 
+    def show_image(self, args):
+        """Display an image immediately through the command queue"""
+        if not args:
+            print("Usage: show <id>")
+            return
+        try:
+            answer = self.send_command("show", [args[0]])
+            print(f"✓ {answer}" if answer is not None else "⚠ Queued, no answer yet (application not running?)")
+        except Exception as e:
+            print(f"✗ Error sending show command: {e}")
+
+    def send_raw_command(self, args):
+        """Send an arbitrary command to the application"""
+        if not args:
+            print("Usage: cmd <name> [args]")
+            return
+        try:
+            start_time = time.time()
+            answer = self.send_command(args[0], args[1:])
+            latency = (time.time() - start_time) * 1000
+            if answer is not None:
+                print(f"{answer} ({latency:.1f}ms)")
+            else:
+                print("⚠ Queued, no answer yet (application not running?)")
+        except Exception as e:
+            print(f"✗ Error sending command: {e}")
+
     def get_current_image(self, args=None):
         """Get current image ID"""
         try:
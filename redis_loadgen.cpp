@@ -0,0 +1,276 @@
+// Switch latency under load: changes the image id at a set rate and pattern, then matches the
+// viewers' App:Displayed acks (AckStream) to the changes - latency from SET/PUBLISH to the ack
+// arriving back here, the viewers' own key-change -> present time, and how many changes were
+// never shown (superseded by a newer one or lost). Any number of viewers on the same key.
+//   make redis_loadgen && ./redis_loadgen [--host H] [--port P] [--key ImageId | --channel App:ImageChanged]
+//       [--ids 0-5] [--rate 5] [--count 100] [--pattern sequential|random|bursty] [--burst 5]
+//       [--stream App:Displayed] [--grace-ms 2000]
+
+#include <hiredis/hiredis.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <map>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "logger.h"
+#include "print.h"
+#include "redis_conn.h"
+#include "stage_metrics.h"
+
+Logger gLogger; // redis_conn.cpp logs through it
+
+struct Options {
+    std::string host = "127.0.0.1";
+    int port = 6379;
+    std::string key = "ImageId";
+    std::string channel; // set: PUBLISH the id here instead of SET key
+    int firstId = 0, lastId = 5;
+    double rate = 5;     // changes per second, on average
+    int count = 100;
+    std::string pattern = "sequential";
+    int burst = 5;       // bursty: changes sent back to back, then a pause
+    std::string stream = "App:Displayed";
+    int graceMs = 2000;  // wait for late acks after the last change
+};
+
+struct Change { std::string id; uint64_t sentNs; };
+struct Ack { std::string instance, id; uint64_t receivedNs; uint64_t viewerUs; };
+
+static bool parseArgs(int argc, char* argv[], Options& o)
+{
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        if (i + 1 >= argc) return false;
+        std::string value = argv[++i];
+        if (arg == "--host") o.host = value;
+        else if (arg == "--port") o.port = atoi(value.c_str());
+        else if (arg == "--key") o.key = value;
+        else if (arg == "--channel") o.channel = value;
+        else if (arg == "--ids") {
+            if (sscanf(value.c_str(), "%d-%d", &o.firstId, &o.lastId) != 2) return false;
+            if (o.lastId <= o.firstId) {
+                // every change must differ from the one before (viewers ignore repeats)
+                println("--ids ", value, ": need a range of at least 2 ids");
+                return false;
+            }
+        }
+        else if (arg == "--rate") o.rate = atof(value.c_str());
+        else if (arg == "--count") o.count = atoi(value.c_str());
+        else if (arg == "--pattern") o.pattern = value;
+        else if (arg == "--burst") o.burst = std::max(1, atoi(value.c_str()));
+        else if (arg == "--stream") o.stream = value;
+        else if (arg == "--grace-ms") o.graceMs = atoi(value.c_str());
+        else return false;
+    }
+    return o.rate > 0 && o.count > 0 &&
+           (o.pattern == "sequential" || o.pattern == "random" || o.pattern == "bursty");
+}
+
+//-------------------------------------------------------------------
+//* Ack reader: XREAD BLOCK on its own connection, from the stream's last entry at start
+class AckReader {
+public:
+    bool Start(const Options& o)
+    {
+        ctx = redisConnect(o.host.c_str(), o.port);
+        if (ctx == nullptr || ctx->err) {
+            return false;
+        }
+        stream = o.stream;
+
+        redisReply* last = (redisReply*)redisCommand(ctx, "XREVRANGE %s + - COUNT 1", stream.c_str());
+        if (last && last->type == REDIS_REPLY_ARRAY && last->elements > 0 && last->element[0]->elements > 0) {
+            lastEntry = last->element[0]->element[0]->str;
+        }
+        freeReplyObject(last);
+
+        thread = std::thread([this] { loop(); });
+        return true;
+    }
+
+    std::vector<Ack> Stop()
+    {
+        stop = true;
+        if (thread.joinable()) thread.join();
+        if (ctx) redisFree(ctx);
+        ctx = nullptr;
+        std::lock_guard<std::mutex> lock(mtx);
+        return acks;
+    }
+
+private:
+    void loop()
+    {
+        while (!stop)
+        {
+            redisReply* r = (redisReply*)redisCommand(ctx, "XREAD BLOCK 100 STREAMS %s %s", stream.c_str(), lastEntry.c_str());
+            uint64_t now = StageClock::NowNs();
+            if (r == nullptr) {
+                println("ack stream: connection lost");
+                return;
+            }
+            // [[stream, [[entry id, [field, value, ...]], ...]]]
+            if (r->type == REDIS_REPLY_ARRAY && r->elements > 0 && r->element[0]->elements == 2)
+            {
+                redisReply* entries = r->element[0]->element[1];
+                std::lock_guard<std::mutex> lock(mtx);
+                for (size_t e = 0; e < entries->elements; ++e)
+                {
+                    redisReply* entry = entries->element[e];
+                    lastEntry = entry->element[0]->str;
+                    Ack ack{"", "", now, 0};
+                    redisReply* fields = entry->element[1];
+                    for (size_t f = 0; f + 1 < fields->elements; f += 2)
+                    {
+                        std::string name = fields->element[f]->str, value = fields->element[f + 1]->str;
+                        if (name == "id") ack.id = value;
+                        else if (name == "instance") ack.instance = value;
+                        else if (name == "latency_us") ack.viewerUs = strtoull(value.c_str(), nullptr, 10);
+                    }
+                    acks.push_back(ack);
+                }
+            }
+            freeReplyObject(r);
+        }
+    }
+
+    redisContext* ctx = nullptr;
+    std::string stream;
+    std::string lastEntry = "0-0";
+    std::thread thread;
+    std::atomic<bool> stop{false};
+    std::mutex mtx;
+    std::vector<Ack> acks;
+};
+
+//-------------------------------------------------------------------
+//* Per viewer: walk its acks in arrival order; an ack for id X matches the latest unmatched
+// change to X sent before it, every change skipped on the way was superseded (never shown)
+struct ViewerResult {
+    uint64_t shown = 0, superseded = 0, lost = 0, unmatched = 0;
+    LatencyHistogram endToEnd; // change sent -> ack received here
+    LatencyHistogram viewer;   // viewer's own key change -> present
+};
+
+static ViewerResult matchAcks(const std::vector<Change>& changes, const std::vector<Ack>& acks)
+{
+    ViewerResult result;
+    int next = 0; // first change not matched or skipped yet
+    for (const Ack& ack : acks)
+    {
+        int match = -1;
+        for (int c = next; c < (int)changes.size() && changes[c].sentNs <= ack.receivedNs; ++c) {
+            if (changes[c].id == ack.id) match = c;
+        }
+        if (match < 0) {
+            result.unmatched++;
+            continue;
+        }
+        result.superseded += match - next;
+        result.shown++;
+        result.endToEnd.Record((ack.receivedNs - changes[match].sentNs) / 1000);
+        result.viewer.Record(ack.viewerUs);
+        next = match + 1;
+    }
+    result.lost = changes.size() - next;
+    return result;
+}
+
+static void printLatency(const char* name, const LatencyHistogram& h)
+{
+    println("  ", name, " p50 ", h.Percentile(50), " us, p95 ", h.Percentile(95), " us, p99 ",
+            h.Percentile(99), " us, max ", h.Max(), " us");
+}
+
+int main(int argc, char* argv[])
+{
+    Options o;
+    if (!parseArgs(argc, argv, o)) {
+        println("usage: redis_loadgen [--host H] [--port P] [--key K | --channel C] [--ids 0-5] [--rate N]"
+                " [--count N] [--pattern sequential|random|bursty] [--burst N] [--stream S] [--grace-ms N]");
+        return 1;
+    }
+
+    RedisConnect redis(o.host, o.port);
+    redis.Connect();
+    AckReader reader;
+    if (!redis.isConnected() || !reader.Start(o)) {
+        println("cannot connect to ", o.host, ":", o.port);
+        return 1;
+    }
+
+    // never start with the id already on screen - the viewers ignore a repeat
+    std::string current = o.channel.empty() ? redis.GetString(o.key) : "";
+    int ids = o.lastId - o.firstId + 1;
+    int seq = current.empty() ? 0 : (atoi(current.c_str()) - o.firstId + 1);
+    std::mt19937 rng(12345);
+    std::string previous = current;
+    auto nextId = [&]() { // terminates: parseArgs guarantees ids >= 2
+        std::string id;
+        do {
+            int n = o.pattern == "random" ? (int)(rng() % ids) : (seq++ % ids + ids) % ids;
+            id = std::to_string(o.firstId + n);
+        } while (id == previous);
+        previous = id;
+        return id;
+    };
+
+    // bursty: the same average rate, but 'burst' changes at once and then a longer pause
+    using clock = std::chrono::steady_clock;
+    auto period = std::chrono::duration<double>(1.0 / o.rate);
+    int perTick = o.pattern == "bursty" ? o.burst : 1;
+    std::vector<Change> changes;
+    auto start = clock::now();
+
+    println("sending ", o.count, " changes to ", o.channel.empty() ? o.key : o.channel, " at ", o.rate,
+            "/s (", o.pattern, "), acks from ", o.stream);
+    for (int i = 0, tick = 0; i < o.count; ++tick)
+    {
+        std::this_thread::sleep_until(start + std::chrono::duration_cast<clock::duration>(period * perTick * tick));
+        for (int b = 0; b < perTick && i < o.count; ++b, ++i)
+        {
+            std::string id = nextId();
+            RedisBatch batch;
+            if (o.channel.empty()) {
+                batch.Set(o.key, id);
+            } else {
+                batch.Command({"PUBLISH", o.channel, id});
+            }
+            changes.push_back({id, StageClock::NowNs()});
+            redis.Exec(batch);
+        }
+    }
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(o.graceMs));
+    std::vector<Ack> acks = reader.Stop();
+
+    std::map<std::string, std::vector<Ack>> byViewer;
+    for (const Ack& ack : acks) {
+        byViewer[ack.instance].push_back(ack);
+    }
+    if (byViewer.empty()) {
+        println("no acks on ", o.stream, " - viewers running with \"AckStream\" set?");
+        return 1;
+    }
+
+    double seconds = std::chrono::duration<double>(clock::now() - start).count() - o.graceMs / 1000.0;
+    println(changes.size(), " changes in ", seconds, " s, ", byViewer.size(), " viewer(s)");
+    for (const auto& [instance, viewerAcks] : byViewer)
+    {
+        ViewerResult r = matchAcks(changes, viewerAcks);
+        println(instance.empty() ? "(unnamed)" : instance, ": shown ", r.shown, ", superseded ", r.superseded,
+                ", lost ", r.lost, ", drop rate ", (double)(r.superseded + r.lost) * 100 / changes.size(), "%",
+                r.unmatched ? ", unmatched acks " + std::to_string(r.unmatched) : std::string());
+        printLatency("change -> ack  ", r.endToEnd);
+        printLatency("viewer         ", r.viewer);
+    }
+    return 0;
+}
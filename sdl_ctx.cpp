@@ -17,8 +17,34 @@ extern Logger gLogger; // declare external logger instance
 #include "sdl_ctx.h"
 
 // Construct
-SDLContext::SDLContext(int w, int h) 
-    : window(nullptr), renderer(nullptr), texture(nullptr), width(w), height(h) {}
+SDLContext::SDLContext(int w, int h, size_t cacheBytes) 
+    : window(nullptr), renderer(nullptr), texture(nullptr), width(w), height(h), imageCache(cacheBytes) 
+{
+    scaler.SetTarget(w, h);
+    framebuffer.SetWorkerPool(&scaler.Pool()); // one set of pixel threads for scale, convert and diff
+    framebuffer.SetStageClock(&stages);
+    kms.SetStageClock(&stages);
+}
+
+void SDLContext::SetScaling(const std::string& mode, const std::string& filter) 
+{
+    scaler.SetMode(ScaleModeFromName(mode));
+    scaler.SetFilter(ScaleFilterFromName(filter));
+
+    // DrawMode 0 scales on the GPU, same filter
+    SDL_SetHint(SDL_HINT_RENDER_SCALE_QUALITY, scaler.Filter() == ScaleFilter::Nearest ? "nearest" : "linear");
+}
+
+void SDLContext::SetTransition(const std::string& kind, int durationMs, int fps) 
+{
+    transition.Configure(TransitionKindFromName(kind), durationMs, fps);
+}
+
+void SDLContext::SetRenderThreads(int threads) 
+{
+    scaler.SetThreads(threads > 0 ? threads : WorkerPool::DefaultThreads());
+    gLogger.log("Render threads: ", scaler.Pool().Threads());
+}
     
 SDLContext::~SDLContext() {
     Shutdown();
@@ -63,6 +89,14 @@ bool SDLContext::tryInitialise()
         return false;
     }
 
+    // decode workers only need SDL_image, not a video driver
+    prefetcher.Start(imageCache.GetBudget() > 0 ? prefetchThreads : 0);
+
+    if (drawMode == 2) 
+    {
+        openFramebuffer(); // kept mapped until Shutdown
+    }
+
 
     // Try multiple video drivers in order of preference
     const char* x11 = getenv("DISPLAY");
@@ -104,6 +138,16 @@ bool SDLContext::tryInitialise()
         win_flags = SDL_WINDOW_FULLSCREEN_DESKTOP;
     }
 
+    if (drawMode == 3) 
+    {
+        // KMS is driven through libdrm - an SDL kmsdrm window would hold DRM master
+        if (!openKms()) {
+            gLogger.log("KMS output not available on ", drmDevice);
+            return false;
+        }
+        return driverFound;
+    }
+
     window = SDL_CreateWindow(title.c_str(),
                                 SDL_WINDOWPOS_UNDEFINED,
                                 SDL_WINDOWPOS_UNDEFINED,
@@ -113,10 +157,20 @@ bool SDLContext::tryInitialise()
         gLogger.log("Window could not be created! SDL_Error: " + std::string(SDL_GetError()));
     }
 
-    renderer = SDL_CreateRenderer(window, -1, SDL_RENDERER_ACCELERATED);
+    // vsync only paces DrawMode 0 transitions - a cut would just wait a refresh for nothing
+    Uint32 rendererFlags = SDL_RENDERER_ACCELERATED | (transition.Enabled() ? SDL_RENDERER_PRESENTVSYNC : 0);
+    renderer = SDL_CreateRenderer(window, -1, rendererFlags);
+    if (renderer == nullptr && window != nullptr) {
+        gLogger.log("Accelerated renderer not available (", SDL_GetError(), "), trying any renderer");
+        renderer = SDL_CreateRenderer(window, -1, 0);
+    }
     if (renderer == nullptr) {
         gLogger.log("Renderer could not be created! SDL_Error: " + std::string(SDL_GetError()));
     }
+    else {
+        SDL_RendererInfo info;
+        rendererVsync = SDL_GetRendererInfo(renderer, &info) == 0 && (info.flags & SDL_RENDERER_PRESENTVSYNC);
+    }
 
     if (!driverFound) 
     {
@@ -130,6 +184,8 @@ bool SDLContext::tryInitialise()
 
 void SDLContext::Shutdown() 
 {
+    prefetcher.Stop(); // no decodes may run past IMG_Quit
+
     if (texture != nullptr) {
         SDL_DestroyTexture(texture);
         texture = nullptr;
@@ -144,6 +200,62 @@ void SDLContext::Shutdown()
     }
     IMG_Quit();
     SDL_Quit();
+    framebuffer.Close();
+    kms.Close();
+    transition.Forget(); // nothing on screen to blend from any more
 
     driverFound = false;
 }
+
+bool SDLContext::RefreshFramebuffer() 
+{
+    if (drawMode != 2) {
+        return true;
+    }
+    fbRetryAt = {}; // an explicit refresh retries a failed open right away
+    return framebuffer.Refresh();
+}
+
+// DrawMode 2/3: a device that failed to open is retried every kFbRetry, not on every image
+bool SDLContext::openFramebuffer()
+{
+    if (framebuffer.isOpen()) {
+        return true;
+    }
+    auto now = std::chrono::steady_clock::now();
+    if (now < fbRetryAt) {
+        return false;
+    }
+    if (framebuffer.Open(fbDevice)) {
+        return true;
+    }
+    fbRetryAt = now + kFbRetry; // Open() has logged why
+    return false;
+}
+
+bool SDLContext::openKms()
+{
+    if (kms.isOpen()) {
+        return true;
+    }
+    auto now = std::chrono::steady_clock::now();
+    if (now < kmsRetryAt) {
+        return false;
+    }
+    if (kms.Open(drmDevice)) {
+        return true;
+    }
+    kmsRetryAt = now + kFbRetry;
+    return false;
+}
+
+std::string SDLContext::VideoDriver() const 
+{
+    const char* name = driverFound ? SDL_GetCurrentVideoDriver() : nullptr;
+    return name ? name : "";
+}
+
+Framebuffer::FlipStats SDLContext::GetFlipStats() const 
+{
+    return drawMode == 3 ? kms.GetFlipStats() : framebuffer.GetFlipStats();
+}
@@ -4,36 +4,119 @@
 #include <SDL2/SDL_image.h>
 
 #include <atomic>
+#include <chrono>
+#include <functional>
 #include <string>
 #include <thread>
+#include <vector>
+
+#include "framebuffer.h"
+#include "image_cache.h"
+#include "image_decode.h"
+#include "image_prefetch.h"
+#include "image_scale.h"
+#include "kms_display.h"
+#include "stage_metrics.h"
+#include "transition.h"
 
 class SDLContext {
+public:
+    struct ProgressiveStats { // DrawMode 2/3 progressive display timings
+        uint64_t images = 0;
+        uint64_t lastFirstRowUs = 0; // decode call -> first row on screen
+        uint64_t lastFullUs = 0;     // decode call -> whole frame on screen
+        uint64_t totalFirstRowUs = 0;
+        uint64_t totalFullUs = 0;
+    };
+
 private:
     SDL_Window* window;
     SDL_Renderer* renderer;
     SDL_Texture* texture;
+    SDL_Rect textureSrc{}, textureDst{}; // placement of texture, outgoing side of a transition
+    bool rendererVsync{false};
     int width;
     int height;
     std::string title{"SDL Window"};
     std::atomic<bool> driverFound{false};
     std::thread autoInitThread;
     std::atomic<bool> stopAutoInit{false};
-    int drawMode{0}; // 0 = DRM, 1 = SDL Blit, 2 = direct framebuffer
+    int drawMode{0}; // 0 = DRM, 1 = SDL Blit, 2 = direct framebuffer, 3 = KMS atomic
     int rgbOrder{0}; // 0 = RGB, 1 = BGR
     int autoInit{0}; // 0 = off, 1 = on
+    ImageCache imageCache; // decoded surfaces, keyed by path
+    ImagePrefetcher prefetcher{imageCache}; // background decode into imageCache
+    int prefetchThreads{0}; // 0 = off
+    Framebuffer framebuffer; // DrawMode 2: mapped once, reused for every image
+    std::string fbDevice{"/dev/fb0"};
+    static constexpr std::chrono::seconds kFbRetry{5}; // fb and KMS
+    std::chrono::steady_clock::time_point fbRetryAt{}; // failed open: not again before this
+    KmsDisplay kms; // DrawMode 3: libdrm dumb buffers + atomic flips, no SDL renderer
+    std::string drmDevice{"/dev/dri/card0"};
+    std::chrono::steady_clock::time_point kmsRetryAt{};
+    ImageScaler scaler; // fit/fill/stretch/center into width x height, tables kept per geometry
+    FrameTransition transition; // crossfade/slide between images, last frame kept in RAM
+    DirectDecoder decoder; // DrawMode 2/3: png/jpeg rows straight into the scanout format
+    bool directDecode{false};
+    bool progressive{false}; // direct decodes land on the visible page row by row
+    StageClock stages; // timestamps of the current switch, fb/kms flips mark their own stages
+    ProgressiveStats progressiveStats;
+
+    using DirectDecode = std::function<DirectDecoder::Result(const DirectDecoder::Target&)>;
+
+    // renders one image into a RAM frame of the scanout size/format
+    using FrameRenderer = std::function<bool(uint8_t* dst, int pitch, int width, int height, DstPixelFormat format)>;
 
     bool tryInitialise();
+    bool openFramebuffer(); // DrawMode 2, throttled retry
+    bool openKms(); // DrawMode 3, same
+    bool displaySurface(SDL_Surface* loadedSurface, const std::string& name);
+    bool displayFbRaw(const std::string& path); // .fbraw: mmap + copy, no decode
+    bool transitionTo(const FrameRenderer& render); // DrawMode 2/3, false = not possible, draw directly
+    bool displayDirect(const DirectDecode& decode); // false = use a surface
+    bool displayProgressive(const DirectDecode& decode); // DrawMode 2/3 into the visible page
+    DirectDecoder::Target directTarget(uint8_t* dst, int pitch, int width, int height, DstPixelFormat format) const;
+    bool presentTexture(SDL_Texture* incoming, const SDL_Rect& src, const SDL_Rect& dst); // DrawMode 0
 
     void startAutoInitialise();
     void stopAutoInitialise();
 public:
-    SDLContext(int w = 640, int h = 480);
+    SDLContext(int w = 640, int h = 480, size_t cacheBytes = 0);
     ~SDLContext();
 
     bool Initialise(std::string title, int drawMode, int rgbOrder, int autoInit);
     bool DisplayImage(const std::string& image_path);
+    bool DisplayCachedImage(const std::string& key, int64_t version); // false if not decoded yet (under this version)
+    bool DisplayImageData(const std::string& key, const void* data, size_t size, int64_t version); // encoded bytes
+    void InvalidateImage(const std::string& key) { imageCache.Invalidate(key); }
     void Shutdown();
     bool isInitialized() const { return driverFound; }
+    std::string VideoDriver() const; // "" before a driver is up
+    ImageCache::Stats GetCacheStats() const { return imageCache.GetStats(); }
+
+    void SetPrefetchThreads(int threads) { prefetchThreads = threads; } // before Initialise
+    void SetDrmDevice(const std::string& device) { drmDevice = device; } // before Initialise
+    void SetFbDevice(const std::string& device) { fbDevice = device; } // before Initialise, see Framebuffer::Open
+    void SetScaling(const std::string& mode, const std::string& filter); // fit|fill|stretch|center|none, bilinear|nearest
+    void SetDirtyTiles(bool on) { framebuffer.SetDirtyTiles(on); } // DrawMode 2: write only changed tiles
+    void SetRenderThreads(int threads); // scale/convert/copy workers incl. the caller, 0 = per core (max 4)
+    void SetTransition(const std::string& kind, int durationMs, int fps); // cut|crossfade|slide
+    void SetDirectDecode(bool on) { directDecode = on && DirectDecoder::Available(); }
+    void SetProgressive(bool on) { progressive = on; } // with DirectDecode, no transition
+    void Prefetch(const std::vector<std::string>& image_paths) { prefetcher.Schedule(image_paths); }
+    ImagePrefetcher::Stats GetPrefetchStats() const { return prefetcher.GetStats(); }
+
+    bool RefreshFramebuffer(); // re-check fb mode (after a mode change event)
+    Framebuffer::FlipStats GetFlipStats() const;
+    DirtyTiles::Stats GetDirtyStats() const { return framebuffer.GetDirtyStats(); }
+    FrameTransition::Stats GetTransitionStats() const { return transition.GetStats(); }
+    DirectDecoder::Stats GetDecodeStats() const { return decoder.GetStats(); }
+    ProgressiveStats GetProgressiveStats() const { return progressiveStats; }
+    StageClock& Stages() { return stages; } // Begin() before a Display call, read after it
 };
 
-extern bool DirectFramebufferWrite(SDL_Surface *loadedSurface, int rgbOrder); //= 0 RGB, 1 BGR
\ No newline at end of file
+extern bool ConvertSurfaceInto(uint8_t *dst, int dstPitch, int dstW, int dstH, DstPixelFormat dstFormat,
+                               SDL_Surface *loadedSurface, int rgbOrder, ImageScaler &scaler); // into RAM or scanout memory
+extern bool DirectFramebufferWrite(Framebuffer &fb, SDL_Surface *loadedSurface, int rgbOrder, ImageScaler &scaler); //= 0 RGB, 1 BGR
+extern bool KmsDisplayWrite(KmsDisplay &kms, SDL_Surface *loadedSurface, int rgbOrder, ImageScaler &scaler); //= 0 RGB, 1 BGR
+extern bool SurfaceWrite(SDL_Surface *target, SDL_Surface *loadedSurface, int rgbOrder, ImageScaler &scaler); // DrawMode 1
\ No newline at end of file
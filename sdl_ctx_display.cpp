@@ -1,4 +1,8 @@
+#include <algorithm>
+#include <chrono>
+
 #include "sdl_ctx.h"
+#include "fbraw.h"
 
 #include "logger.h"
 extern Logger gLogger; // declare external logger instance
@@ -6,52 +10,413 @@ extern Logger gLogger; // declare external logger instance
 
 bool SDLContext::DisplayImage(const std::string& image_path) 
 {
-    if (texture != nullptr) 
-    {
-        SDL_DestroyTexture(texture);
-        texture = nullptr;
+    if (FbRawImage::IsFbRawPath(image_path)) {
+        return displayFbRaw(image_path);
     }
+
+    prefetcher.Claim(image_path); // stop speculative work, wait if it's already decoding this one
+
+    // not decoded yet: straight from the file into the scanout buffer if it's placed 1:1
+    // (no surface is left for the cache - the next show decodes again)
+    if (directDecode && !imageCache.Has(image_path) &&
+        displayDirect([&](const DirectDecoder::Target& target) { return decoder.DecodeFile(image_path, target); })) {
+        return true;
+    }
+
+    // decoded surface from cache, or IMG_Load on miss (cache keeps it for next time)
+    SurfacePtr image = imageCache.Load(image_path);
     
-    SDL_Surface* loadedSurface = IMG_Load(image_path.c_str());
-    
-    if (loadedSurface == nullptr) 
+    if (image == nullptr) 
+    {
+        return false; // already logged by the cache
+    }
+    stages.Mark(PipelineStage::Decoded);
+    return displaySurface(image.get(), image_path);
+}
+
+bool SDLContext::DisplayCachedImage(const std::string& key, int64_t version) 
+{
+    SurfacePtr image = imageCache.Cached(key, version);
+    if (image == nullptr) {
+        return false;
+    }
+    stages.Mark(PipelineStage::Decoded);
+    return displaySurface(image.get(), key);
+}
+
+bool SDLContext::DisplayImageData(const std::string& key, const void* data, size_t size, int64_t version) 
+{
+    if (directDecode &&
+        displayDirect([&](const DirectDecoder::Target& target) { return decoder.DecodeMemory(data, size, target); })) {
+        return true; // not cached: the next show fetches the blob again
+    }
+
+    SurfacePtr image = imageCache.Decode(key, data, size, version);
+    if (image == nullptr) {
+        return false;
+    }
+    stages.Mark(PipelineStage::Decoded);
+    return displaySurface(image.get(), key);
+}
+
+bool SDLContext::displayFbRaw(const std::string& path) 
+{
+    FbRawImage raw;
+    if (!raw.Open(path)) {
+        return false;
+    }
+    stages.Mark(PipelineStage::Opened); // mapped, nothing to decode
+
+    auto copyRaw = [&](uint8_t* dst, int pitch, int width, int height, DstPixelFormat format) {
+        return raw.CopyInto(dst, pitch, width, height, format);
+    };
+
+    if (drawMode == 2)
+    {
+        if (!openFramebuffer()) {
+            return false;
+        }
+
+        if (transition.Enabled() && transitionTo(copyRaw)) {
+            return true;
+        }
+        transition.Forget();
+
+        const fb_var_screeninfo& vinfo = framebuffer.VInfo();
+        if (!raw.CopyInto(framebuffer.DrawBuffer(), framebuffer.DrawPitch(),
+                          vinfo.xres, vinfo.yres, DstFormatFromVInfo(vinfo))) {
+            return false;
+        }
+        framebuffer.Flip();
+        return true;
+    }
+    else if (drawMode == 3)
+    {
+        if (!openKms()) {
+            return false;
+        }
+        if (transition.Enabled() && transitionTo(copyRaw)) {
+            return true;
+        }
+        transition.Forget();
+
+        KmsDisplay::Buffer* back = kms.BackBuffer();
+        if (back == nullptr || !raw.CopyInto(back->pixels, back->pitch, back->width, back->height, back->format)) {
+            return false;
+        }
+        return kms.Present();
+    }
+
+    // SDL paths: wrap the mapping as a surface, no copy
+    const FbRawHeader& h = raw.Header();
+    Uint32 sdlFormat = raw.Format() == DstPixelFormat::RGB565   ? SDL_PIXELFORMAT_RGB565
+                     : raw.Format() == DstPixelFormat::BGR565   ? SDL_PIXELFORMAT_BGR565
+                     : raw.Format() == DstPixelFormat::XRGB8888 ? SDL_PIXELFORMAT_XRGB8888
+                                                                : SDL_PIXELFORMAT_XBGR8888;
+    SDL_Surface* surface = SDL_CreateRGBSurfaceWithFormatFrom((void*)raw.Pixels(), h.width, h.height,
+                                                              DstBytesPerPixel(raw.Format()) * 8, h.stride, sdlFormat);
+    if (surface == nullptr) {
+        LOGW("Unable to wrap ", path, "! SDL_Error: ", SDL_GetError());
+        return false;
+    }
+
+    bool ok = displaySurface(surface, path);
+    SDL_FreeSurface(surface);
+    return ok;
+}
+
+DirectDecoder::Target SDLContext::directTarget(uint8_t* dst, int pitch, int w, int h, DstPixelFormat format) const
+{
+    DirectDecoder::Target target;
+    target.pixels = dst;
+    target.pitch = pitch;
+    target.width = w;
+    target.height = h;
+    target.format = format;
+    target.box = scaler.TargetBox(w, h);
+    target.mode = scaler.Mode();
+    target.swapRB = rgbOrder == 1;
+    return target;
+}
+
+bool SDLContext::displayDirect(const DirectDecode& decode) 
+{
+    auto render = [&](uint8_t* dst, int pitch, int w, int h, DstPixelFormat format) {
+        if (decode(directTarget(dst, pitch, w, h, format)) != DirectDecoder::Result::Done) {
+            return false;
+        }
+        stages.Mark(PipelineStage::Decoded); // rows already in the scanout format
+        return true;
+    };
+
+    // transitions decode into their RAM frame; on failure the surface path takes over
+    if (transition.Enabled() && (drawMode == 2 || drawMode == 3)) {
+        return transitionTo(render);
+    }
+    if (progressive && (drawMode == 2 || drawMode == 3)) {
+        return displayProgressive(decode);
+    }
+
+    if (drawMode == 2)
+    {
+        if (!openFramebuffer()) {
+            return false;
+        }
+        const fb_var_screeninfo& vinfo = framebuffer.VInfo();
+        if (!render(framebuffer.DrawBuffer(), framebuffer.DrawPitch(), vinfo.xres, vinfo.yres, DstFormatFromVInfo(vinfo))) {
+            return false;
+        }
+        framebuffer.Flip();
+        return true;
+    }
+    else if (drawMode == 3)
+    {
+        if (!openKms()) {
+            return false;
+        }
+        KmsDisplay::Buffer* back = kms.BackBuffer();
+        if (back == nullptr || !render(back->pixels, back->pitch, back->width, back->height, back->format)) {
+            return false;
+        }
+        return kms.Present();
+    }
+    return false;
+}
+
+bool SDLContext::displayProgressive(const DirectDecode& decode) 
+{
+    using clock = std::chrono::steady_clock;
+    auto usSince = [](clock::time_point from) {
+        return (uint64_t)std::chrono::duration_cast<std::chrono::microseconds>(clock::now() - from).count();
+    };
+
+    DirectDecoder::Target target;
+    if (drawMode == 2)
+    {
+        if (!openFramebuffer()) {
+            return false;
+        }
+        const fb_var_screeninfo& vinfo = framebuffer.VInfo();
+        target = directTarget(framebuffer.FrontBuffer(), framebuffer.FInfo().line_length,
+                              vinfo.xres, vinfo.yres, DstFormatFromVInfo(vinfo));
+    }
+    else
+    {
+        if (!openKms()) {
+            return false;
+        }
+        KmsDisplay::Buffer* front = kms.FrontBuffer();
+        if (front == nullptr) {
+            return false;
+        }
+        target = directTarget(front->pixels, front->pitch, front->width, front->height, front->format);
+    }
+
+    // no back page, no flip: every row is visible as soon as it's converted
+    auto start = clock::now();
+    uint64_t firstRowUs = 0;
+    target.progress = [&](int) {
+        if (firstRowUs == 0) {
+            firstRowUs = std::max<uint64_t>(usSince(start), 1);
+        }
+        if (drawMode == 3) {
+            kms.FlushFront();
+        }
+    };
+
+    DirectDecoder::Result result = decode(target);
+    if (drawMode == 2) {
+        framebuffer.InvalidateTiles(); // the page behind the diff changed
+    } else {
+        kms.FlushFront();
+    }
+    if (result != DirectDecoder::Result::Done) {
+        return false; // Unsupported touched nothing; Failed left part of a frame the surface path replaces
+    }
+
+    stages.Mark(PipelineStage::Decoded);
+    stages.Mark(PipelineStage::Presented); // the last row is on screen as soon as it's written
+
+    uint64_t fullUs = usSince(start);
+    progressiveStats.images++;
+    progressiveStats.lastFirstRowUs = firstRowUs;
+    progressiveStats.lastFullUs = fullUs;
+    progressiveStats.totalFirstRowUs += firstRowUs;
+    progressiveStats.totalFullUs += fullUs;
+    return true;
+}
+
+bool SDLContext::transitionTo(const FrameRenderer& render) 
+{
+    int outW = 0, outH = 0;
+    DstPixelFormat format = DstPixelFormat::Unknown;
+    FrameTransition::Step step;
+    bool vsync = true;
+
+    if (drawMode == 2 && framebuffer.isOpen())
+    {
+        const fb_var_screeninfo& vinfo = framebuffer.VInfo();
+        outW = vinfo.xres;
+        outH = vinfo.yres;
+        format = DstFormatFromVInfo(vinfo);
+        vsync = framebuffer.isVsynced();
+        step = [this](int t) {
+            transition.Compose(t, framebuffer.BackBuffer(), framebuffer.FInfo().line_length, scaler.Pool());
+            framebuffer.FlipBackBuffer(); // every step changes most tiles - no diff
+            return true;
+        };
+    }
+    else if (drawMode == 3 && kms.BackBuffer() != nullptr)
     {
-        gLogger.log("Unable to load image " + image_path + "! IMG_Error: " + std::string(IMG_GetError()));
+        KmsDisplay::Buffer* back = kms.BackBuffer();
+        outW = back->width;
+        outH = back->height;
+        format = back->format;
+        step = [this](int t) {
+            KmsDisplay::Buffer* buffer = kms.BackBuffer();
+            if (buffer == nullptr) {
+                return false;
+            }
+            transition.Compose(t, buffer->pixels, buffer->pitch, scaler.Pool());
+            return kms.Present(); // returns once the flip happened
+        };
+    }
+
+    if (format == DstPixelFormat::Unknown) {
         return false;
     }
 
+    uint8_t* frame = transition.Incoming(outW, outH, format);
+    if (frame == nullptr || !render(frame, transition.Pitch(), outW, outH, format)) {
+        return false;
+    }
+    stages.Mark(PipelineStage::Converted);
+
+    // first image (or new mode): nothing to blend from
+    bool ok = transition.HasCurrent() ? transition.Run(step, vsync) : step(256);
+    transition.Finish();
+    return ok;
+}
+
+bool SDLContext::presentTexture(SDL_Texture* incoming, const SDL_Rect& src, const SDL_Rect& dst) 
+{
+    if (texture != nullptr && transition.Enabled())
+    {
+        int outW = width, outH = height;
+        SDL_GetRendererOutputSize(renderer, &outW, &outH);
+        SDL_SetTextureBlendMode(incoming, SDL_BLENDMODE_BLEND);
+
+        transition.Run([&](int t)
+        {
+            SDL_RenderClear(renderer);
+            if (transition.Kind() == TransitionKind::Slide)
+            {
+                int shift = outW * t / 256;
+                SDL_Rect out = textureDst, in = dst;
+                out.x -= shift;
+                in.x += outW - shift;
+                SDL_RenderCopy(renderer, texture, &textureSrc, &out);
+                SDL_RenderCopy(renderer, incoming, &src, &in);
+            }
+            else
+            {
+                SDL_RenderCopy(renderer, texture, &textureSrc, &textureDst);
+                SDL_SetTextureAlphaMod(incoming, (Uint8)std::min(t, 255));
+                SDL_RenderCopy(renderer, incoming, &src, &dst);
+            }
+            SDL_RenderPresent(renderer);
+            stages.Mark(PipelineStage::Presented); // first step counts
+            return true;
+        }, rendererVsync);
+
+        SDL_SetTextureAlphaMod(incoming, 255);
+    }
+
+    SDL_RenderClear(renderer);
+    SDL_RenderCopy(renderer, incoming, &src, &dst);
+    SDL_RenderPresent(renderer);
+    stages.Mark(PipelineStage::Presented);
+
+    if (texture != nullptr) {
+        SDL_DestroyTexture(texture);
+    }
+    texture = incoming;
+    textureSrc = src;
+    textureDst = dst;
+    return true;
+}
+
+bool SDLContext::displaySurface(SDL_Surface* loadedSurface, const std::string& name) 
+{
+    // DrawMode 2/3 transitions render the image into a RAM frame first
+    auto renderImage = [&](uint8_t* dst, int pitch, int w, int h, DstPixelFormat format) {
+        return ConvertSurfaceInto(dst, pitch, w, h, format, loadedSurface, rgbOrder, scaler);
+    };
+
     if( driverFound && drawMode == 0 )
     {
         // kmsdrm 
-        texture = SDL_CreateTextureFromSurface(renderer, loadedSurface);
+        SDL_Texture* incoming = SDL_CreateTextureFromSurface(renderer, loadedSurface);
         
-        if (texture == nullptr) {
-            gLogger.log("Unable to create texture from " + image_path + "! SDL_Error: " + std::string(SDL_GetError()));
+        if (incoming == nullptr) {
+            LOGW("Unable to create texture from ", name, "! SDL_Error: ", SDL_GetError());
             return false;
         }
+        stages.Mark(PipelineStage::Converted); // uploaded
+
+        // placement per ScaleMode, the GPU does the resampling
+        int outW = width, outH = height;
+        SDL_GetRendererOutputSize(renderer, &outW, &outH);
+        ScaleRect srcRect, dstRect;
+        ComputePlacement(loadedSurface->w, loadedSurface->h, scaler.TargetBox(outW, outH),
+                         scaler.Mode(), srcRect, dstRect);
+        SDL_Rect src = {srcRect.x, srcRect.y, srcRect.w, srcRect.h};
+        SDL_Rect dst = {dstRect.x, dstRect.y, dstRect.w, dstRect.h};
 
-        SDL_RenderClear(renderer);
-        SDL_RenderCopy(renderer, texture, NULL, NULL);
-        SDL_RenderPresent(renderer);
+        // the old texture stays until the new one is up (outgoing side of a transition)
+        presentTexture(incoming, src, dst);
     }
     else if( drawMode == 1)
     {
-        // Direct framebuffer access (bypass SDL rendering)
-        SDL_Rect dstrect = {0, 0, loadedSurface->w, loadedSurface->h};
-
+        // Window surface: scaled + converted in software, then shown
         SDL_Surface* screenSurface = SDL_GetWindowSurface(window);
-        // Option A: Use SDL_BlitSurface
-        SDL_BlitSurface(loadedSurface, NULL, screenSurface, NULL);        
+        if (screenSurface == nullptr || !SurfaceWrite(screenSurface, loadedSurface, rgbOrder, scaler)) {
+            return false;
+        }
+        stages.Mark(PipelineStage::Converted);
         SDL_UpdateWindowSurface(window);
+        stages.Mark(PipelineStage::Presented);
     }
     else if( drawMode == 2)
     {
         // Direct framebuffer write
-        DirectFramebufferWrite(loadedSurface, rgbOrder);
+        if (!openFramebuffer()) { // device may have shown up after init
+            return false;
+        }
+        if (transition.Enabled() && transitionTo(renderImage)) {
+            return true;
+        }
+        transition.Forget();
+        if (!DirectFramebufferWrite(framebuffer, loadedSurface, rgbOrder, scaler)) {
+            LOGW("Framebuffer write failed for ", name);
+            return false;
+        }
+    }
+    else if( drawMode == 3)
+    {
+        // libdrm atomic page flip
+        if (!openKms()) {
+            return false;
+        }
+        if (transition.Enabled() && transitionTo(renderImage)) {
+            return true;
+        }
+        transition.Forget();
+        if (!KmsDisplayWrite(kms, loadedSurface, rgbOrder, scaler)) {
+            LOGW("KMS present failed for ", name);
+            return false;
+        }
     }
-
-
-    SDL_FreeSurface(loadedSurface);
 
 
     return true;
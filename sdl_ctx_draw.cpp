@@ -1,87 +1,197 @@
 #include "SDL_surface.h"
+#include "logger.h"
 #include "print.h"
 #include <SDL2/SDL.h>
-#include <fcntl.h>
-#include <sys/mman.h>
-#include <sys/ioctl.h>
-#include <linux/fb.h>
-#include <unistd.h>
-#include <cstring>
 #include <algorithm>
+#include <atomic>
+#include <cstring>
 
-bool DirectFramebufferWrite(SDL_Surface *inputSurface, int rgbOrder) //= 0 RGB, 1 BGR
+#include "framebuffer.h"
+#include "image_scale.h"
+#include "kms_display.h"
+#include "pixel_convert.h"
+
+SrcPixelFormat SrcFormatFromSDL(Uint32 sdlFormat)
 {
-  int fb_fd = open("/dev/fb0", O_RDWR);
-  if (fb_fd >= 0) 
-  {
-    struct fb_var_screeninfo vinfo;
-    struct fb_fix_screeninfo finfo;
-    ioctl(fb_fd, FBIOGET_VSCREENINFO, &vinfo);
-    ioctl(fb_fd, FBIOGET_FSCREENINFO, &finfo);
+  switch (sdlFormat) {
+    case SDL_PIXELFORMAT_RGBA32:
+    case SDL_PIXELFORMAT_XBGR8888: return SrcPixelFormat::RGBA8888; // R,G,B,(A|X) in memory
+    case SDL_PIXELFORMAT_BGRA32:
+    case SDL_PIXELFORMAT_XRGB8888: return SrcPixelFormat::BGRA8888;
+    case SDL_PIXELFORMAT_RGB24:    return SrcPixelFormat::RGB888;
+    case SDL_PIXELFORMAT_BGR24:    return SrcPixelFormat::BGR888;
+    default:                       return SrcPixelFormat::Unknown;
+  }
+}
 
-    println("vinfo: xres=", vinfo.xres, " yres=", vinfo.yres,
-            " xres_virtual=", vinfo.xres_virtual,
-            " yres_virtual=", vinfo.yres_virtual,
-            " bits_per_pixel=", vinfo.bits_per_pixel);
-    println("finfo: line_length=", finfo.line_length,
-            " smem_len=", finfo.smem_len);
+static DstPixelFormat DstFormatFromSDL(Uint32 sdlFormat)
+{
+  switch (sdlFormat) {
+    case SDL_PIXELFORMAT_RGB565:   return DstPixelFormat::RGB565;
+    case SDL_PIXELFORMAT_BGR565:   return DstPixelFormat::BGR565;
+    case SDL_PIXELFORMAT_XRGB8888:
+    case SDL_PIXELFORMAT_ARGB8888: return DstPixelFormat::XRGB8888; // alpha byte written as 0xFF
+    case SDL_PIXELFORMAT_XBGR8888:
+    case SDL_PIXELFORMAT_ABGR8888: return DstPixelFormat::XBGR8888;
+    default:                       return DstPixelFormat::Unknown;
+  }
+}
 
-    long screensize = vinfo.yres_virtual * finfo.line_length;
+// fb formats without a kernel (8/24 bpp, odd offsets): let SDL convert to whatever vinfo says,
+// straight into the destination in row chunks over the pool (SDL_ConvertPixels is reentrant)
+static bool sdlConvertAndCopy(uint8_t *fbp, int pitch, const fb_var_screeninfo &vinfo,
+                              SDL_Surface *inputSurface, WorkerPool &pool)
+{
+  auto mask = [](const fb_bitfield &f) -> Uint32 { return f.length ? ((1u << f.length) - 1) << f.offset : 0; };
+  Uint32 fbFormat = SDL_MasksToPixelFormatEnum(vinfo.bits_per_pixel, mask(vinfo.red),
+                                               mask(vinfo.green), mask(vinfo.blue), 0);
+
+  // paletted sources can't go through SDL_ConvertPixels: one single-threaded pass to RGBA first
+  SDL_Surface *normalized = nullptr;
+  SDL_Surface *surface = inputSurface;
+  if (SDL_ISPIXELFORMAT_INDEXED(surface->format->format)) {
+    normalized = SDL_ConvertSurfaceFormat(inputSurface, SDL_PIXELFORMAT_RGBA32, 0);
+    if (normalized == nullptr) {
+      PRINTW("## draw direct: convert failed: ", SDL_GetError());
+      return false;
+    }
+    surface = normalized;
+  }
 
-    char *fbp = (char *)mmap(0, screensize, PROT_READ | PROT_WRITE, MAP_SHARED,
-                             fb_fd, 0);
+  int width = std::min(surface->w, (int)vinfo.xres);
+  int rows = std::min(surface->h, (int)vinfo.yres);
+  int chunks = (rows + ImageScaler::kChunkRows - 1) / ImageScaler::kChunkRows;
+  std::atomic<bool> ok{true};
 
-    SDL_Surface *loadedSurface = inputSurface;
-    SDL_Surface *surface_16bpp = nullptr;
-    SDL_LockSurface(loadedSurface);
+  SDL_LockSurface(surface);
+  pool.Run(chunks, [&](int c)
+  {
+    int y0 = c * ImageScaler::kChunkRows;
+    int n = std::min(ImageScaler::kChunkRows, rows - y0);
+    if (SDL_ConvertPixels(width, n, surface->format->format, (uint8_t *)surface->pixels + (long)y0 * surface->pitch,
+                          surface->pitch, fbFormat, fbp + (long)y0 * pitch, pitch) != 0) {
+      ok = false;
+    }
+  });
+  SDL_UnlockSurface(surface);
 
-    println("## input surface: w=", loadedSurface->w, " h=", loadedSurface->h,
-            " pitch=", loadedSurface->pitch,
-            " bpp=", loadedSurface->format->BitsPerPixel);
+  if (!ok) {
+    PRINTW("## draw direct: convert failed: ", SDL_GetError());
+  }
+  if (normalized) {
+    SDL_FreeSurface(normalized);
+  }
+  return ok;
+}
+
+// Scale/convert the surface into a mapped scanout buffer; anything the image doesn't cover is
+// cleared so older frames in a recycled page/buffer never show around it
+bool ConvertSurfaceInto(uint8_t *dst, int dstPitch, int dstW, int dstH,
+                        DstPixelFormat dstFormat, SDL_Surface *inputSurface, int rgbOrder,
+                        ImageScaler &scaler)
+{
+  // paletted / 16-bit PNGs etc: normalise once, then use the kernels
+  SDL_Surface *normalized = nullptr;
+  SDL_Surface *surface = inputSurface;
+  SrcPixelFormat srcFormat = SrcFormatFromSDL(surface->format->format);
+  if (srcFormat == SrcPixelFormat::Unknown) {
+    normalized = SDL_ConvertSurfaceFormat(inputSurface, SDL_PIXELFORMAT_RGBA32, 0);
+    if (normalized == nullptr) {
+      PRINTW("## draw direct: convert failed: ", SDL_GetError());
+      return false;
+    }
+    surface = normalized;
+    srcFormat = SrcPixelFormat::RGBA8888;
+  }
 
-    if (fbp != MAP_FAILED) 
-    {
-      int srcBpp = loadedSurface->format->BitsPerPixel;
-      int destBpp = vinfo.bits_per_pixel;
+  ScaleRect srcRect, dstRect;
+  ComputePlacement(surface->w, surface->h, scaler.TargetBox(dstW, dstH), scaler.Mode(), srcRect, dstRect);
 
-      println("## draw direct (mmap) start, srcBpp=", srcBpp,
-              " destBpp=", destBpp);
+  SDL_LockSurface(surface);
+  bool ok = scaler.ScaleInto((const uint8_t *)surface->pixels, surface->pitch, srcFormat, srcRect,
+                             dst, dstPitch, dstFormat, dstRect, rgbOrder == 1);
+  SDL_UnlockSurface(surface);
 
-      if (srcBpp != destBpp) {
-        SDL_UnlockSurface(loadedSurface);
+  // letterbox / pillarbox bars and anything outside the target box
+  int bpp = DstBytesPerPixel(dstFormat);
+  int chunks = (dstH + ImageScaler::kChunkRows - 1) / ImageScaler::kChunkRows;
+  scaler.Pool().Run(chunks, [&](int c)
+  {
+    int y0 = c * ImageScaler::kChunkRows;
+    int y1 = std::min(y0 + ImageScaler::kChunkRows, dstH);
+    for (int y = y0; y < y1; y++) {
+      uint8_t *row = dst + (long)y * dstPitch;
+      if (y < dstRect.y || y >= dstRect.y + dstRect.h) {
+        memset(row, 0, (size_t)dstW * bpp);
+        continue;
+      }
+      memset(row, 0, (size_t)dstRect.x * bpp);
+      memset(row + (dstRect.x + dstRect.w) * bpp, 0, (size_t)(dstW - dstRect.x - dstRect.w) * bpp);
+    }
+  });
 
-        surface_16bpp = SDL_ConvertSurfaceFormat(
-            loadedSurface, SDL_PIXELFORMAT_RGB565,
-            0 // Flags are generally unused and should be 0 in SDL2
-        );
+  if (normalized) {
+    SDL_FreeSurface(normalized);
+  }
+  return ok;
+}
 
-        loadedSurface = surface_16bpp;
-        SDL_LockSurface(loadedSurface);
-      }
+// fb is opened and mapped once by SDLContext - this is only convert + copy
+bool DirectFramebufferWrite(Framebuffer &fb, SDL_Surface *inputSurface, int rgbOrder, ImageScaler &scaler) //= 0 RGB, 1 BGR
+{
+  if (!fb.isOpen()) {
+    return false;
+  }
 
-      for (int y = 0; y < loadedSurface->h && y < vinfo.yres; y++) {
-        long fb_location = y * finfo.line_length;
-        long img_location = y * loadedSurface->pitch;
+  const fb_var_screeninfo &vinfo = fb.VInfo();
+  uint8_t *fbp = fb.DrawBuffer(); // RAM copy with dirty tiles, else the off-screen page
+  int pitch = fb.DrawPitch();
 
-        // copy to FB
-        memcpy(fbp + fb_location, (char *)loadedSurface->pixels + img_location,
-               std::min((int)loadedSurface->pitch, (int)finfo.line_length));
-      }
+  DstPixelFormat dstFormat = DstFormatFromVInfo(vinfo);
+  bool ok = dstFormat == DstPixelFormat::Unknown
+              ? sdlConvertAndCopy(fbp, pitch, vinfo, inputSurface, scaler.Pool())
+              : ConvertSurfaceInto(fbp, pitch, vinfo.xres, vinfo.yres,
+                                   dstFormat, inputSurface, rgbOrder, scaler);
 
-      munmap(fbp, screensize);
+  if (ok) {
+    fb.Flip(); // changed tiles out, then tear-free pan to the finished page on vsync
+  }
+  return ok;
+}
 
-      println("## draw direct (mmap) done ");
-    }
+// DrawMode 3: same conversion into a free dumb buffer, then an atomic page flip
+bool KmsDisplayWrite(KmsDisplay &kms, SDL_Surface *inputSurface, int rgbOrder, ImageScaler &scaler) //= 0 RGB, 1 BGR
+{
+  KmsDisplay::Buffer *back = kms.BackBuffer();
+  if (back == nullptr) {
+    return false;
+  }
 
-    SDL_UnlockSurface(loadedSurface);
-    if (surface_16bpp) {
-      SDL_FreeSurface(surface_16bpp);
-    }
+  if (!ConvertSurfaceInto(back->pixels, back->pitch, back->width, back->height,
+                          back->format, inputSurface, rgbOrder, scaler)) {
+    return false;
+  }
 
-    close(fb_fd); // /dev/fb0
+  return kms.Present();
+}
 
-    println("## draw direct all done ");
+// DrawMode 1: into the window surface when its format has a kernel, SDL's scaler otherwise
+bool SurfaceWrite(SDL_Surface *target, SDL_Surface *inputSurface, int rgbOrder, ImageScaler &scaler)
+{
+  DstPixelFormat dstFormat = DstFormatFromSDL(target->format->format);
+  if (dstFormat == DstPixelFormat::Unknown) {
+    ScaleRect srcRect, dstRect;
+    ComputePlacement(inputSurface->w, inputSurface->h, scaler.TargetBox(target->w, target->h),
+                     scaler.Mode(), srcRect, dstRect);
+    SDL_Rect src = {srcRect.x, srcRect.y, srcRect.w, srcRect.h};
+    SDL_Rect dst = {dstRect.x, dstRect.y, dstRect.w, dstRect.h};
+    SDL_FillRect(target, NULL, 0);
+    return SDL_BlitScaled(inputSurface, &src, target, &dst) == 0;
   }
 
-  return fb_fd >= 0;
-}
\ No newline at end of file
+  SDL_LockSurface(target);
+  bool ok = ConvertSurfaceInto((uint8_t *)target->pixels, target->pitch, target->w, target->h,
+                               dstFormat, inputSurface, rgbOrder, scaler);
+  SDL_UnlockSurface(target);
+  return ok;
+}
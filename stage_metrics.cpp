@@ -0,0 +1,110 @@
+#include <algorithm>
+
+#include "stage_metrics.h"
+
+const char* PipelineStageName(PipelineStage stage)
+{
+    switch (stage)
+    {
+        case PipelineStage::Observed:  return "observed";
+        case PipelineStage::Started:   return "started";
+        case PipelineStage::Opened:    return "opened";
+        case PipelineStage::Decoded:   return "decoded";
+        case PipelineStage::Converted: return "converted";
+        case PipelineStage::Written:   return "written";
+        case PipelineStage::Presented: return "presented";
+        default:                       return "?";
+    }
+}
+
+//static
+int LatencyHistogram::bucketOf(uint64_t us)
+{
+    constexpr int sub = 1 << kSubBits;
+    if (us < (uint64_t)sub) {
+        return (int)us;
+    }
+    int e = 63 - __builtin_clzll(us); // >= kSubBits
+    int bucket = sub + (e - kSubBits) * sub + (int)((us >> (e - kSubBits)) & (sub - 1));
+    return std::min(bucket, kBuckets - 1);
+}
+
+//static
+uint64_t LatencyHistogram::bucketTop(int bucket)
+{
+    constexpr int sub = 1 << kSubBits;
+    if (bucket < sub) {
+        return (uint64_t)bucket;
+    }
+    int e = (bucket - sub) / sub + kSubBits;
+    uint64_t low = (uint64_t)(sub + (bucket - sub) % sub) << (e - kSubBits);
+    return low + ((uint64_t)1 << (e - kSubBits)) - 1;
+}
+
+void LatencyHistogram::Record(uint64_t us)
+{
+    buckets[bucketOf(us)]++;
+    count++;
+    sum += us;
+    max = std::max(max, us);
+}
+
+uint64_t LatencyHistogram::Percentile(int pct) const
+{
+    if (count == 0) {
+        return 0;
+    }
+    uint64_t rank = (count * (uint64_t)pct + 99) / 100; // 1-based, nearest rank
+    uint64_t seen = 0;
+    for (int b = 0; b < kBuckets; ++b)
+    {
+        seen += buckets[b];
+        if (seen >= rank) {
+            return b == kBuckets - 1 ? max : std::min(bucketTop(b), max); // last bucket is open-ended
+        }
+    }
+    return max;
+}
+
+void PipelineMetrics::Record(const StageClock& clock)
+{
+    uint64_t observed = clock.At(PipelineStage::Observed);
+    uint64_t presented = clock.At(PipelineStage::Presented);
+    if (observed == 0 || presented == 0) {
+        return;
+    }
+
+    uint64_t last = observed;
+    for (int s = (int)PipelineStage::Observed + 1; s < (int)PipelineStage::Count; ++s)
+    {
+        uint64_t at = clock.At((PipelineStage)s);
+        if (at == 0) {
+            continue;
+        }
+        stages[s].Record(at > last ? (at - last) / 1000 : 0);
+        last = std::max(last, at);
+    }
+    total.Record(presented > observed ? (presented - observed) / 1000 : 0);
+}
+
+std::vector<std::string> PipelineMetrics::HashFields() const
+{
+    std::vector<std::string> fields;
+    auto add = [&](const std::string& name, const LatencyHistogram& h) {
+        if (h.Count() == 0) {
+            return;
+        }
+        fields.insert(fields.end(), {
+            name + "_p50_us", std::to_string(h.Percentile(50)),
+            name + "_p95_us", std::to_string(h.Percentile(95)),
+            name + "_p99_us", std::to_string(h.Percentile(99)),
+            name + "_max_us", std::to_string(h.Max()),
+            name + "_count",  std::to_string(h.Count())});
+    };
+
+    for (int s = (int)PipelineStage::Observed + 1; s < (int)PipelineStage::Count; ++s) {
+        add(PipelineStageName((PipelineStage)s), stages[s]);
+    }
+    add("total", total);
+    return fields;
+}
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Redis -> pixels, in order. Not every path marks every stage: SDL_image and the direct decoder
+// open and decode in one call (no Opened), the direct decoder writes rows in the scanout format
+// (Converted right after Decoded), KMS dumb buffers are scanned out as drawn (no Written).
+enum class PipelineStage : int {
+    Observed,  // key change seen: keyspace/channel push, poll timer
+    Started,   // id known, display call entered (after the GET round trip)
+    Opened,    // source bytes available: blob fetched, .fbraw mapped
+    Decoded,   // pixels decoded (surface from cache or SDL_image, or direct decode done)
+    Converted, // frame in the scanout format: RAM frame, back page, dumb buffer, texture
+    Written,   // changed tiles copied to the fb page
+    Presented, // on screen: pan/flip after vsync, RenderPresent, UpdateWindowSurface
+    Count
+};
+
+const char* PipelineStageName(PipelineStage stage); // "observed", "started", ...
+
+//-------------------------------------------------------------------
+//* Monotonic timestamps of one image switch - the first mark of a stage wins, so a transition
+// counts as presented when its first step is on screen.
+class StageClock {
+public:
+    static uint64_t NowNs()
+    {
+        return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    void Begin(uint64_t observedNs) // new switch, older marks dropped
+    {
+        marks.fill(0);
+        marks[(int)PipelineStage::Observed] = observedNs ? observedNs : NowNs();
+    }
+
+    void Mark(PipelineStage stage)
+    {
+        uint64_t& at = marks[(int)stage];
+        if (at == 0 && marks[(int)PipelineStage::Observed] != 0) {
+            at = NowNs();
+        }
+    }
+
+    uint64_t At(PipelineStage stage) const { return marks[(int)stage]; } // 0 = not marked
+
+private:
+    std::array<uint64_t, (size_t)PipelineStage::Count> marks{};
+};
+
+//-------------------------------------------------------------------
+//* Fixed-bucket latency histogram in microseconds: exact below 8 us, then 8 buckets per power
+// of two (within 12.5%). Record is a bit scan and an increment, percentiles walk ~250 counters.
+class LatencyHistogram {
+public:
+    void Record(uint64_t us);
+    uint64_t Count() const { return count; }
+    uint64_t Max() const { return max; }
+    uint64_t Mean() const { return count ? sum / count : 0; }
+    uint64_t Percentile(int pct) const; // upper edge of the bucket holding it, capped at Max()
+
+private:
+    static constexpr int kSubBits = 3;
+    static constexpr int kBuckets = (1 << kSubBits) * 31; // up to 2^32 us
+
+    static int bucketOf(uint64_t us);
+    static uint64_t bucketTop(int bucket);
+
+    std::array<uint32_t, kBuckets> buckets{};
+    uint64_t count = 0;
+    uint64_t sum = 0;
+    uint64_t max = 0;
+};
+
+//-------------------------------------------------------------------
+//* Per-stage histograms of finished switches: each marked stage is timed from the latest
+// earlier marked one, plus "total" from Observed to Presented.
+class PipelineMetrics {
+public:
+    void Record(const StageClock& clock); // switches without Presented are ignored
+    uint64_t Switches() const { return total.Count(); }
+    const LatencyHistogram& Stage(PipelineStage stage) const { return stages[(int)stage]; }
+    const LatencyHistogram& Total() const { return total; }
+
+    // field/value pairs for HSET: <stage>_p50_us, _p95_us, _p99_us, _max_us, _count
+    std::vector<std::string> HashFields() const;
+
+private:
+    std::array<LatencyHistogram, (size_t)PipelineStage::Count> stages;
+    LatencyHistogram total;
+};
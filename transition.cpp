@@ -0,0 +1,203 @@
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <thread>
+
+#if defined(__ARM_NEON)
+#include <arm_neon.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#include "transition.h"
+
+namespace {
+
+constexpr int kChunkRows = 16; // rows per pool task, same as the convert path
+
+// 0..256 -> 0..256, slow at both ends
+int ease(int t)
+{
+    t = std::clamp(t, 0, 256);
+    return (int)((int64_t)t * t * (768 - 2 * t) / 65536);
+}
+
+// 32-bit pixels: every byte blended, the X byte does not matter
+void blendRow32(const uint8_t* a, const uint8_t* b, uint8_t* out, int bytes, int w)
+{
+    int i = 0;
+#if defined(__ARM_NEON)
+    for (; i + 16 <= bytes; i += 16)
+    {
+        uint8x16_t va = vld1q_u8(a + i), vb = vld1q_u8(b + i);
+        uint16x8_t lo = vmulq_n_u16(vmovl_u8(vget_low_u8(va)), (uint16_t)(256 - w));
+        uint16x8_t hi = vmulq_n_u16(vmovl_u8(vget_high_u8(va)), (uint16_t)(256 - w));
+        lo = vmlaq_n_u16(lo, vmovl_u8(vget_low_u8(vb)), (uint16_t)w);
+        hi = vmlaq_n_u16(hi, vmovl_u8(vget_high_u8(vb)), (uint16_t)w);
+        vst1q_u8(out + i, vcombine_u8(vrshrn_n_u16(lo, 8), vrshrn_n_u16(hi, 8)));
+    }
+#elif defined(__SSE2__)
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i wb = _mm_set1_epi16((short)w), wa = _mm_set1_epi16((short)(256 - w));
+    const __m128i round = _mm_set1_epi16(128);
+    for (; i + 16 <= bytes; i += 16)
+    {
+        __m128i va = _mm_loadu_si128((const __m128i*)(a + i));
+        __m128i vb = _mm_loadu_si128((const __m128i*)(b + i));
+        __m128i lo = _mm_add_epi16(_mm_mullo_epi16(_mm_unpacklo_epi8(va, zero), wa),
+                                   _mm_mullo_epi16(_mm_unpacklo_epi8(vb, zero), wb));
+        __m128i hi = _mm_add_epi16(_mm_mullo_epi16(_mm_unpackhi_epi8(va, zero), wa),
+                                   _mm_mullo_epi16(_mm_unpackhi_epi8(vb, zero), wb));
+        lo = _mm_srli_epi16(_mm_add_epi16(lo, round), 8);
+        hi = _mm_srli_epi16(_mm_add_epi16(hi, round), 8);
+        _mm_storeu_si128((__m128i*)(out + i), _mm_packus_epi16(lo, hi));
+    }
+#endif
+    for (; i < bytes; ++i) {
+        out[i] = (uint8_t)((a[i] * (256 - w) + b[i] * w + 128) >> 8);
+    }
+}
+
+// 5-6-5 pixels: fields spread apart in a 32-bit word, all three blended with one multiply each
+void blendRow565(const uint8_t* a, const uint8_t* b, uint8_t* out, int pixels, int w)
+{
+    const uint16_t* pa = (const uint16_t*)a;
+    const uint16_t* pb = (const uint16_t*)b;
+    uint16_t* po = (uint16_t*)out;
+    uint32_t w5 = (uint32_t)(w >> 3); // 0..32
+    for (int x = 0; x < pixels; ++x)
+    {
+        uint32_t xa = (pa[x] | ((uint32_t)pa[x] << 16)) & 0x07E0F81F;
+        uint32_t xb = (pb[x] | ((uint32_t)pb[x] << 16)) & 0x07E0F81F;
+        uint32_t r = ((xa * (32 - w5) + xb * w5) >> 5) & 0x07E0F81F;
+        po[x] = (uint16_t)(r | (r >> 16));
+    }
+}
+
+} // namespace
+
+TransitionKind TransitionKindFromName(const std::string& name)
+{
+    if (name == "crossfade") return TransitionKind::Crossfade;
+    if (name == "slide") return TransitionKind::Slide;
+    return TransitionKind::Cut;
+}
+
+void FrameTransition::Configure(TransitionKind kind, int durationMs, int fps)
+{
+    this->kind = kind;
+    this->durationMs = std::max(0, durationMs);
+    periodUs = 1000000 / std::clamp(fps, 1, 240);
+
+    if (!Enabled()) {
+        current.clear();
+        current.shrink_to_fit();
+        incoming.clear();
+        incoming.shrink_to_fit();
+        width = height = 0;
+        hasCurrent = false;
+    }
+}
+
+uint8_t* FrameTransition::Incoming(int width, int height, DstPixelFormat format)
+{
+    if (width != this->width || height != this->height || format != this->format || incoming.empty())
+    {
+        this->width = width;
+        this->height = height;
+        this->format = format;
+        bpp = DstBytesPerPixel(format);
+        pitch = width * bpp;
+        current.assign((size_t)pitch * height, 0);
+        incoming.assign((size_t)pitch * height, 0);
+        hasCurrent = false;
+    }
+    return incoming.empty() ? nullptr : incoming.data();
+}
+
+void FrameTransition::Compose(int t, uint8_t* dst, int dstPitch, WorkerPool& pool) const
+{
+    int rowBytes = width * bpp;
+    int shift = kind == TransitionKind::Slide ? width * t / 256 : 0; // columns of the incoming frame shown
+    bool done = t >= 256 || !hasCurrent || kind == TransitionKind::Cut;
+
+    int chunks = (height + kChunkRows - 1) / kChunkRows;
+    pool.Run(chunks, [&](int c)
+    {
+        int y0 = c * kChunkRows, y1 = std::min(y0 + kChunkRows, height);
+        for (int y = y0; y < y1; ++y)
+        {
+            const uint8_t* a = current.data() + (size_t)y * pitch;
+            const uint8_t* b = incoming.data() + (size_t)y * pitch;
+            uint8_t* out = dst + (size_t)y * dstPitch;
+
+            if (done) {
+                memcpy(out, b, rowBytes);
+            }
+            else if (kind == TransitionKind::Slide) {
+                int keep = width - shift;
+                memcpy(out, a + (size_t)shift * bpp, (size_t)keep * bpp);
+                memcpy(out + (size_t)keep * bpp, b, (size_t)shift * bpp);
+            }
+            else if (bpp == 4) {
+                blendRow32(a, b, out, rowBytes, t);
+            }
+            else if (bpp == 2) {
+                blendRow565(a, b, out, width, t);
+            }
+            else {
+                memcpy(out, t < 128 ? a : b, rowBytes);
+            }
+        }
+    });
+}
+
+void FrameTransition::Finish()
+{
+    current.swap(incoming);
+    hasCurrent = !current.empty();
+}
+
+bool FrameTransition::Run(const Step& step, bool vsync)
+{
+    using clock = std::chrono::steady_clock;
+    auto usSince = [](clock::time_point from) {
+        return (int64_t)std::chrono::duration_cast<std::chrono::microseconds>(clock::now() - from).count();
+    };
+
+    const int64_t totalUs = (int64_t)durationMs * 1000;
+    auto start = clock::now();
+    auto last = start;
+    bool ok = true;
+
+    for (int frame = 1; ; ++frame)
+    {
+        // position by the clock, aimed at when this frame reaches the screen - late frames skip ahead
+        int64_t due = usSince(start) + periodUs;
+        int t = due >= totalUs ? 256 : (int)(due * 256 / totalUs);
+
+        if (!step(ease(t))) {
+            ok = false;
+            break;
+        }
+
+        int64_t interval = usSince(last);
+        last = clock::now();
+        stats.frames++;
+        stats.maxFrameUs = std::max(stats.maxFrameUs, (uint64_t)interval);
+        if (frame > 1 && interval > periodUs * 3 / 2) {
+            stats.dropped += (uint64_t)((interval + periodUs / 2) / periodUs - 1);
+        }
+
+        if (t >= 256) {
+            break;
+        }
+        if (!vsync) {
+            std::this_thread::sleep_until(start + std::chrono::microseconds((int64_t)frame * periodUs));
+        }
+    }
+
+    stats.transitions++;
+    stats.lastMs = (uint64_t)usSince(start) / 1000;
+    return ok;
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "pixel_convert.h"
+#include "worker_pool.h"
+
+enum class TransitionKind { Cut, Crossfade, Slide };
+// Cut       - the new image replaces the old one in one frame (the old behaviour)
+// Crossfade - blend old -> new
+// Slide     - the new image pushes the old one out to the left
+
+TransitionKind TransitionKindFromName(const std::string& name); // "crossfade", "slide", anything else = Cut
+
+//-------------------------------------------------------------------
+//* Image change transitions - the outgoing and incoming frames stay in RAM in the scanout format,
+// every step is blended straight into the back buffer and presented on the next vsync.
+class FrameTransition {
+public:
+    struct Stats {
+        uint64_t transitions = 0;
+        uint64_t frames = 0;     // steps presented
+        uint64_t dropped = 0;    // refresh periods missed between steps
+        uint64_t lastMs = 0;     // wall time of the latest transition
+        uint64_t maxFrameUs = 0; // longest present-to-present interval
+    };
+
+    // Draw and present step t: 0 = outgoing only, 256 = incoming only (eased)
+    using Step = std::function<bool(int t)>;
+
+    void Configure(TransitionKind kind, int durationMs, int fps); // fps: nominal refresh
+    bool Enabled() const { return kind != TransitionKind::Cut && durationMs > 0; }
+    TransitionKind Kind() const { return kind; }
+
+    // RAM frame to render the next image into; a new geometry/format forgets the current frame
+    uint8_t* Incoming(int width, int height, DstPixelFormat format);
+    int Pitch() const { return pitch; }
+    bool HasCurrent() const { return hasCurrent; }
+
+    void Compose(int t, uint8_t* dst, int dstPitch, WorkerPool& pool) const; // current -> incoming at t
+    void Finish(); // incoming is now the current frame
+    void Forget() { hasCurrent = false; } // screen was drawn some other way
+
+    // Runs steps until the duration is over, at least the final one (t = 256).
+    // vsync: step() blocks until its frame is on screen; otherwise steps are paced by sleeping.
+    bool Run(const Step& step, bool vsync);
+
+    Stats GetStats() const { return stats; }
+
+private:
+    TransitionKind kind{TransitionKind::Cut};
+    int durationMs{0};
+    int periodUs{16667};
+
+    int width{0}, height{0}, bpp{0}, pitch{0};
+    DstPixelFormat format{DstPixelFormat::Unknown};
+    std::vector<uint8_t> current;
+    std::vector<uint8_t> incoming;
+    bool hasCurrent{false};
+    Stats stats;
+};
@@ -0,0 +1,109 @@
+#include <algorithm>
+
+#include "worker_pool.h"
+
+
+WorkerPool::WorkerPool(int threads)
+{
+    start(threads);
+}
+
+WorkerPool::~WorkerPool()
+{
+    stop();
+}
+
+//static
+int WorkerPool::DefaultThreads()
+{
+    return std::clamp((int)std::thread::hardware_concurrency(), 1, 4);
+}
+
+void WorkerPool::Resize(int threads)
+{
+    if (std::max(1, threads) == Threads()) {
+        return;
+    }
+    stop();
+    start(threads);
+}
+
+void WorkerPool::start(int threads)
+{
+    quit = false;
+    for (int i = 1; i < threads; ++i) {
+        workers.emplace_back(&WorkerPool::workerLoop, this);
+    }
+}
+
+void WorkerPool::stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        quit = true;
+    }
+    cvWork.notify_all();
+
+    for (auto& t : workers) {
+        t.join();
+    }
+    workers.clear();
+}
+
+void WorkerPool::Run(int tasks, const Task& fn)
+{
+    if (tasks <= 0) {
+        return;
+    }
+    if (workers.empty() || tasks == 1) {
+        for (int i = 0; i < tasks; ++i) fn(i);
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        job = &fn;
+        taskCount = tasks;
+        nextTask = 0;
+        finished = 0;
+        generation++;
+    }
+    cvWork.notify_all();
+
+    drain(); // the caller works too
+
+    // every worker checks in for this generation - none can wander into the next Run late
+    std::unique_lock<std::mutex> lock(mtx);
+    cvDone.wait(lock, [this] { return finished == (int)workers.size(); });
+    job = nullptr;
+}
+
+void WorkerPool::drain()
+{
+    for (int i = nextTask++; i < taskCount; i = nextTask++) {
+        (*job)(i);
+    }
+}
+
+void WorkerPool::workerLoop()
+{
+    uint64_t seen = 0;
+    std::unique_lock<std::mutex> lock(mtx);
+
+    while (true)
+    {
+        cvWork.wait(lock, [&] { return quit || generation != seen; });
+        if (quit) {
+            return;
+        }
+        seen = generation;
+
+        lock.unlock();
+        drain();
+        lock.lock();
+
+        if (++finished == (int)workers.size()) {
+            cvDone.notify_one();
+        }
+    }
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+//-------------------------------------------------------------------
+//* Fork-join pool for per-frame pixel work - Run() splits tasks over the workers and the caller
+// Threads stay parked between frames; one Run() at a time (render path is single-threaded).
+class WorkerPool {
+public:
+    using Task = std::function<void(int task)>;
+
+    explicit WorkerPool(int threads = 1); // total incl. the calling thread, 1 = run inline
+    ~WorkerPool();
+
+    WorkerPool(const WorkerPool&) = delete;
+    WorkerPool& operator=(const WorkerPool&) = delete;
+
+    void Resize(int threads);
+    int Threads() const { return (int)workers.size() + 1; }
+
+    void Run(int tasks, const Task& fn); // returns when every task is done
+
+    static int DefaultThreads(); // online cores, at most 4
+
+private:
+    void start(int threads);
+    void stop();
+    void workerLoop();
+    void drain(); // take tasks until none are left
+
+    std::vector<std::thread> workers;
+    std::mutex mtx;
+    std::condition_variable cvWork;
+    std::condition_variable cvDone;
+    bool quit = false;
+    uint64_t generation = 0; // bumped per Run
+
+    const Task* job = nullptr;
+    int taskCount = 0;
+    std::atomic<int> nextTask{0};
+    int finished = 0; // workers done with the current generation
+};